@@ -0,0 +1,407 @@
+#include "ast_cache.h"
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <functional>
+#include <type_traits>
+#include <system_error>
+
+#include "content_hash.h"
+#include "mapped_file.h"
+
+namespace barnack::text_parser
+	{
+	namespace
+		{
+		constexpr std::array<char, 8> ast_cache_magic{'B', 'N', 'K', 'A', 'S', 'T', '\r', '\n'};
+		//Reads back differently on a machine with the other byte order.
+		constexpr uint32_t byte_order_mark{0x01020304};
+
+		struct file_header
+			{
+			std::array<char, 8> magic;
+			uint32_t format_version;
+			uint32_t parser_version;
+			uint32_t char_size;
+			uint32_t byte_order;
+			uint32_t identifiers;
+			uint32_t nodes_count;
+			uint32_t parameters_count;
+			uint32_t reserved;
+			uint64_t key;
+			uint64_t source_size;
+			uint64_t strings_size; //Code units of the decoded strings table.
+			};
+		static_assert(sizeof(file_header) == 64 && std::is_trivially_copyable_v<file_header>);
+
+		enum class value_type : uint32_t { none, integer, floating, source_string, decoded_string };
+
+		//Numbers as their bits, strings as offset and size in code units into the source or into the decoded strings table.
+		struct value_record
+			{
+			value_type type;
+			uint32_t size;
+			uint64_t bits;
+			};
+		static_assert(sizeof(value_record) == 16 && std::is_trivially_copyable_v<value_record>);
+		static_assert(sizeof(compact_range<uint32_t>) == 8 && std::is_trivially_copyable_v<compact_range<uint32_t>>);
+
+		//Offsets of the arrays following the header, each one aligned to 8 bytes.
+		struct file_layout
+			{
+			size_t kinds;
+			size_t ranges;
+			size_t first_children;
+			size_t next_siblings;
+			size_t parameters_firsts;
+			size_t parameters_counts;
+			size_t parameters;
+			size_t parameters_kinds;
+			size_t parameters_values;
+			size_t strings;
+			size_t size;
+
+			file_layout(size_t nodes_count, size_t parameters_count, size_t strings_size, size_t char_size) noexcept
+				{
+				size_t it{sizeof(file_header)};
+				const auto next{[&it](size_t count, size_t element_size)
+					{
+					const size_t ret{it};
+					it = (it + count * element_size + 7) & ~size_t{7};
+					return ret;
+					}};
+				kinds             = next(nodes_count     , sizeof(uint8_t));
+				ranges            = next(nodes_count     , sizeof(compact_range<uint32_t>));
+				first_children    = next(nodes_count     , sizeof(uint32_t));
+				next_siblings     = next(nodes_count     , sizeof(uint32_t));
+				parameters_firsts = next(nodes_count     , sizeof(uint32_t));
+				parameters_counts = next(nodes_count     , sizeof(uint32_t));
+				parameters        = next(parameters_count, sizeof(compact_range<uint32_t>));
+				parameters_kinds  = next(parameters_count, sizeof(uint8_t));
+				parameters_values = next(parameters_count, sizeof(value_record));
+				strings           = next(strings_size    , char_size);
+				size = it;
+				}
+			};
+
+		template <typename char_t>
+		bool is_within(std::basic_string_view<char_t> string, std::basic_string_view<char_t> container) noexcept
+			{
+			const std::less_equal<const char_t*> less_equal;
+			return less_equal(container.data(), string.data()) && less_equal(string.data() + string.size(), container.data() + container.size());
+			}
+		}
+
+	template <typename char_t>
+	ast_cache<char_t>::ast_cache(std::filesystem::path directory, identifier_syntax identifiers) : directory{std::move(directory)}, identifiers{identifiers} {}
+
+	template <typename char_t>
+	uint64_t ast_cache<char_t>::key_of(view_t source) const noexcept
+		{
+		const uint64_t seed{(uint64_t{format_version} << 48) ^ (uint64_t{parser_version} << 16) ^ (uint64_t{sizeof(char_t)} << 8) ^ static_cast<uint64_t>(identifiers)};
+		return content_hash(source, seed);
+		}
+
+	template <typename char_t>
+	std::filesystem::path ast_cache<char_t>::path_of(uint64_t key) const
+		{
+		constexpr char digits[]{"0123456789abcdef"};
+		std::string name(16, '0');
+		for (size_t i{0}; i < 16; i++) { name[15 - i] = digits[(key >> (i * 4)) & 0xF]; }
+		return directory / (name + ".ast");
+		}
+
+	template <typename char_t>
+	std::filesystem::path ast_cache<char_t>::path_of(view_t source) const
+		{
+		return path_of(key_of(source));
+		}
+
+	template <typename char_t>
+	void ast_cache<char_t>::append_children(flat_tree_t& tree, typename flat_tree_t::index_t parent, const typename tree_parser_t::sequence& children)
+		{
+		using index_t = typename flat_tree_t::index_t;
+		index_t last_child{flat_tree_t::none};
+
+		tree_parser_t::for_each_element(children, [&](const auto& element)
+			{
+			index_t index;
+			if (const auto command_ptr{std::get_if<typename tree_parser_t::command>(&element)})
+				{
+				const auto& command{*command_ptr};
+				index = tree.add_node(flat_tree_t::node_kind::command, tree.lines.compact(command.name), command.name_symbol);
+				for (const auto& parameter : command.parameters)
+					{
+					tree.parameters        .push_back(tree.lines.compact(parameter));
+					tree.parameters_symbols.push_back(parameter.symbol);
+					tree.parameters_kinds  .push_back(parameter.kind);
+					tree.parameters_values .push_back(parameter.value);
+					}
+				tree.parameters_counts[index] = static_cast<index_t>(command.parameters.size());
+				append_children(tree, index, command.children);
+				}
+			else
+				{
+				index = tree.add_node(flat_tree_t::node_kind::raw, tree.lines.compact(std::get<typename tokeniser_t::range>(element)));
+				}
+
+			if (last_child == flat_tree_t::none) { tree.first_children[parent] = index; }
+			else                                 { tree.next_siblings[last_child] = index; }
+			last_child = index;
+			});
+		}
+
+	template <typename char_t>
+	void ast_cache<char_t>::store(view_t source, const typename tree_parser_t::command& root) const
+		{
+		flat_tree_t tree{source};
+		append_children(tree, 0, root.children);
+		store(tree);
+		}
+
+	template <typename char_t>
+	void ast_cache<char_t>::store(const flat_tree_t& tree) const
+		{
+		const view_t source{tree.source};
+		const size_t nodes_count     {tree.size()};
+		const size_t parameters_count{tree.parameters.size()};
+
+		std::vector<uint8_t> parameters_kinds(parameters_count);
+		std::vector<value_record> values(parameters_count);
+		std::basic_string<char_t> strings;
+		for (size_t i{0}; i < parameters_count; i++)
+			{
+			parameters_kinds[i] = static_cast<uint8_t>(tree.parameters_kinds[i]);
+
+			const auto& value{tree.parameters_values[i]};
+			if      (const auto integer_ptr {std::get_if<int64_t>(&value)}) { values[i] = {value_type::integer , 0, std::bit_cast<uint64_t>(*integer_ptr )}; }
+			else if (const auto floating_ptr{std::get_if<double >(&value)}) { values[i] = {value_type::floating, 0, std::bit_cast<uint64_t>(*floating_ptr)}; }
+			else if (const auto string_ptr  {std::get_if<view_t >(&value)})
+				{
+				const view_t string{*string_ptr};
+				if (is_within(string, source))
+					{
+					values[i] = {value_type::source_string, static_cast<uint32_t>(string.size()), static_cast<uint64_t>(string.data() - source.data())};
+					}
+				else
+					{
+					values[i] = {value_type::decoded_string, static_cast<uint32_t>(string.size()), static_cast<uint64_t>(strings.size())};
+					strings += string;
+					}
+				}
+			else { values[i] = {value_type::none, 0, 0}; }
+			}
+
+		const uint64_t key{key_of(source)};
+		const file_header header
+			{
+			.magic           {ast_cache_magic},
+			.format_version  {format_version},
+			.parser_version  {parser_version},
+			.char_size       {sizeof(char_t)},
+			.byte_order      {byte_order_mark},
+			.identifiers     {static_cast<uint32_t>(identifiers)},
+			.nodes_count     {static_cast<uint32_t>(nodes_count)},
+			.parameters_count{static_cast<uint32_t>(parameters_count)},
+			.reserved        {0},
+			.key             {key},
+			.source_size     {source.size()},
+			.strings_size    {strings.size()}
+			};
+		const file_layout layout{nodes_count, parameters_count, strings.size(), sizeof(char_t)};
+
+		//Zero initialized, so that padding is the same on every write.
+		std::vector<std::byte> bytes(layout.size);
+		const auto write{[&bytes](size_t offset, const void* data, size_t size)
+			{
+			if (size > 0) { std::memcpy(bytes.data() + offset, data, size); }
+			}};
+		write(0                       , &header                       , sizeof(header));
+		write(layout.kinds            , tree.kinds            .data(), nodes_count      * sizeof(uint8_t));
+		write(layout.ranges           , tree.ranges           .data(), nodes_count      * sizeof(compact_range<uint32_t>));
+		write(layout.first_children   , tree.first_children   .data(), nodes_count      * sizeof(uint32_t));
+		write(layout.next_siblings    , tree.next_siblings    .data(), nodes_count      * sizeof(uint32_t));
+		write(layout.parameters_firsts, tree.parameters_firsts.data(), nodes_count      * sizeof(uint32_t));
+		write(layout.parameters_counts, tree.parameters_counts.data(), nodes_count      * sizeof(uint32_t));
+		write(layout.parameters       , tree.parameters       .data(), parameters_count * sizeof(compact_range<uint32_t>));
+		write(layout.parameters_kinds , parameters_kinds      .data(), parameters_count * sizeof(uint8_t));
+		write(layout.parameters_values, values                .data(), parameters_count * sizeof(value_record));
+		write(layout.strings          , strings               .data(), strings.size()   * sizeof(char_t));
+
+		std::filesystem::create_directories(directory);
+		const std::filesystem::path path{path_of(key)};
+		//Unique per writer, concurrent stores of the same entry don't write into each other's file.
+		std::filesystem::path temporary_path{path};
+		temporary_path += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "." + std::to_string(std::chrono::system_clock::now().time_since_epoch().count()) + ".tmp";
+
+		std::error_code error;
+			{
+			std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+			file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			file.close();
+			if (!file)
+				{
+				std::filesystem::remove(temporary_path, error);
+				throw std::runtime_error{"Error writing the AST cache file \"" + temporary_path.string() + "\"."};
+				}
+			}
+		std::filesystem::rename(temporary_path, path, error);
+		if (error)
+			{
+			std::error_code remove_error;
+			std::filesystem::remove(temporary_path, remove_error);
+			throw std::system_error{error, "Error renaming \"" + temporary_path.string() + "\" to \"" + path.string() + "\""};
+			}
+		}
+
+	template <typename char_t>
+	std::optional<typename ast_cache<char_t>::entry> ast_cache<char_t>::load(view_t source, utils::observer_ptr<const symbol_table> symbol_table_ptr) const
+		{
+		using node_kind  = typename flat_tree_t::node_kind;
+		using token_kind = typename tokeniser_t::token_kind;
+
+		const uint64_t key{key_of(source)};
+		const std::filesystem::path path{path_of(key)};
+
+		std::error_code error;
+		if (!std::filesystem::exists(path, error)) { return std::nullopt; }
+		std::optional<mapped_file> file;
+		//The entry may be replaced or removed between the check and the mapping.
+		try { file.emplace(path); }
+		catch (const std::system_error&) { return std::nullopt; }
+
+		const auto bytes{file->bytes()};
+		if (bytes.size() < sizeof(file_header)) { return std::nullopt; }
+		file_header header;
+		std::memcpy(&header, bytes.data(), sizeof(header));
+		const bool header_matches
+			{
+			header.magic            == ast_cache_magic                    &&
+			header.format_version   == format_version                     &&
+			header.parser_version   == parser_version                     &&
+			header.char_size        == sizeof(char_t)                     &&
+			header.byte_order       == byte_order_mark                    &&
+			header.identifiers      == static_cast<uint32_t>(identifiers) &&
+			header.key              == key                                &&
+			header.source_size      == source.size()                      &&
+			header.nodes_count      >  0                                  &&
+			header.strings_size     <= bytes.size()
+			};
+		if (!header_matches) { return std::nullopt; }
+
+		const size_t nodes_count     {header.nodes_count};
+		const size_t parameters_count{header.parameters_count};
+		const size_t strings_size    {static_cast<size_t>(header.strings_size)};
+		const file_layout layout{nodes_count, parameters_count, strings_size, sizeof(char_t)};
+		if (layout.size != bytes.size()) { return std::nullopt; }
+
+		entry ret{flat_tree_t{source}, {}};
+		auto& tree{ret.tree};
+
+		const auto read{[&bytes]<typename T>(std::vector<T>& destination, size_t offset, size_t count)
+			{
+			destination.resize(count);
+			if (count > 0) { std::memcpy(destination.data(), bytes.data() + offset, count * sizeof(T)); }
+			}};
+		std::vector<uint8_t> parameters_kinds;
+		std::vector<value_record> values;
+		read(tree.kinds            , layout.kinds            , nodes_count);
+		read(tree.ranges           , layout.ranges           , nodes_count);
+		read(tree.first_children   , layout.first_children   , nodes_count);
+		read(tree.next_siblings    , layout.next_siblings    , nodes_count);
+		read(tree.parameters_firsts, layout.parameters_firsts, nodes_count);
+		read(tree.parameters_counts, layout.parameters_counts, nodes_count);
+		read(tree.parameters       , layout.parameters       , parameters_count);
+		read(parameters_kinds      , layout.parameters_kinds , parameters_count);
+		read(values                , layout.parameters_values, parameters_count);
+
+		const char_t* strings{nullptr};
+		if (strings_size > 0)
+			{
+			char_t* destination{ret.strings.allocate(strings_size)};
+			std::memcpy(destination, bytes.data() + layout.strings, strings_size * sizeof(char_t));
+			strings = destination;
+			}
+
+		//A damaged file must not send walks out of bounds, into cycles or twice through the same subtree:
+		//links only point forward, as they do in preorder, and no node is the child or sibling of more than one node.
+		std::vector<bool> referenced(nodes_count, false);
+		const auto valid_range{[&source](const compact_range<uint32_t>& range) { return range.begin <= range.end && range.end <= source.size(); }};
+		const auto valid_link {[nodes_count, &referenced](size_t index, uint32_t link)
+			{
+			if (link == flat_tree_t::none) { return true; }
+			if (link <= index || link >= nodes_count || referenced[link]) { return false; }
+			referenced[link] = true;
+			return true;
+			}};
+		const auto valid_slice{[](uint64_t offset, uint64_t size, size_t container_size) { return offset <= container_size && size <= container_size - offset; }};
+
+		if (tree.kinds[0] != node_kind::command) { return std::nullopt; }
+		for (size_t i{0}; i < nodes_count; i++)
+			{
+			const bool is_command{tree.kinds[i] == node_kind::command};
+			const bool valid
+				{
+				(is_command || tree.kinds[i] == node_kind::raw) &&
+				valid_range(tree.ranges[i]) &&
+				valid_link(i, tree.first_children[i]) &&
+				valid_link(i, tree.next_siblings [i]) &&
+				valid_slice(tree.parameters_firsts[i], tree.parameters_counts[i], parameters_count) &&
+				(is_command || (tree.first_children[i] == flat_tree_t::none && tree.parameters_counts[i] == 0))
+				};
+			if (!valid) { return std::nullopt; }
+			}
+
+		tree.symbols           .assign(nodes_count     , symbol_table::none);
+		tree.parameters_symbols.assign(parameters_count, symbol_table::none);
+		tree.parameters_kinds  .resize(parameters_count);
+		tree.parameters_values .resize(parameters_count);
+		for (size_t i{0}; i < parameters_count; i++)
+			{
+			if (!valid_range(tree.parameters[i]) || parameters_kinds[i] > static_cast<uint8_t>(token_kind::string)) { return std::nullopt; }
+			tree.parameters_kinds[i] = static_cast<token_kind>(parameters_kinds[i]);
+
+			const value_record& record{values[i]};
+			auto& value{tree.parameters_values[i]};
+			switch (record.type)
+				{
+				case value_type::none    : value = std::monostate{}; break;
+				case value_type::integer : value = std::bit_cast<int64_t>(record.bits); break;
+				case value_type::floating: value = std::bit_cast<double >(record.bits); break;
+				case value_type::source_string:
+					if (!valid_slice(record.bits, record.size, source.size())) { return std::nullopt; }
+					value = source.substr(static_cast<size_t>(record.bits), record.size);
+					break;
+				case value_type::decoded_string:
+					if (!valid_slice(record.bits, record.size, strings_size)) { return std::nullopt; }
+					value = view_t{strings + record.bits, record.size};
+					break;
+				default: return std::nullopt;
+				}
+			}
+
+		if (symbol_table_ptr)
+			{
+			for (size_t i{1}; i < nodes_count; i++)
+				{
+				if (tree.kinds[i] == node_kind::command) { tree.symbols[i] = symbol_table_ptr->find(tree.ranges[i].string(source)); }
+				}
+			for (size_t i{0}; i < parameters_count; i++)
+				{
+				if (tree.parameters_kinds[i] == token_kind::identifier) { tree.parameters_symbols[i] = symbol_table_ptr->find(tree.parameters[i].string(source)); }
+				}
+			}
+
+		return ret;
+		}
+
+	template class ast_cache<char16_t>;
+	template class ast_cache<char8_t>;
+	template class ast_cache<char>;
+	}
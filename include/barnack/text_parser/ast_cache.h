@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <filesystem>
+
+#include <utils/memory.h>
+
+#include "tokeniser.h"
+#include "parser_base.h"
+#include "tree_parser.h"
+#include "flat_tree.h"
+#include "symbol_table.h"
+#include "string_arena.h"
+
+namespace barnack::text_parser
+	{
+	//Parsed trees kept on disk, so that loading an unchanged document again doesn't tokenise it.
+	//Files are named after the content_hash of the source, seeded with the format and parser versions, the character type and the identifier syntax.
+	//They hold the arrays of a flat_tree: ranges as offsets into the source, parameter kinds and decoded values, nesting as node indices.
+	//Arrays are aligned and in native byte order, a mapping of the file is validated and copied into the tree as is.
+	//A file whose header doesn't match the source and settings, or that fails validation, is treated as a miss.
+	template <typename CHAR_T>
+	class ast_cache
+		{
+		public:
+			using char_t            = CHAR_T;
+			using view_t            = std::basic_string_view<char_t>;
+			using tokeniser_t       = tokeniser<char_t>;
+			using tree_parser_t     = tree_parser<char_t>;
+			using flat_tree_t       = flat_tree<char_t>;
+			using identifier_syntax = typename tokeniser_t::identifier_syntax;
+
+			//Bumped whenever the file layout changes.
+			static constexpr uint32_t format_version{1};
+
+			//Tree read back from a file. String parameters that had escape sequences point into strings, the rest of the tree into the source.
+			struct entry
+				{
+				flat_tree_t tree;
+				string_arena<char_t> strings;
+				};
+
+			//identifiers must be the syntax of the tokenisers the stored trees are parsed with.
+			ast_cache(std::filesystem::path directory, identifier_syntax identifiers = identifier_syntax::ascii);
+
+			std::filesystem::path directory;
+			identifier_syntax identifiers;
+
+			std::filesystem::path path_of(view_t source) const;
+
+			//Symbols are not persisted since they depend on the table, they're looked up again in symbol_table_ptr when given.
+			std::optional<entry> load(view_t source, utils::observer_ptr<const symbol_table> symbol_table_ptr = nullptr) const;
+
+			//root must have been parsed from source. Files are written aside and renamed over the previous entry, readers never see them partially written.
+			void store(view_t source, const typename tree_parser_t::command& root) const;
+			void store(const flat_tree_t& tree) const;
+
+		private:
+			uint64_t key_of(view_t source) const noexcept;
+			std::filesystem::path path_of(uint64_t key) const;
+
+			static void append_children(flat_tree_t& tree, typename flat_tree_t::index_t parent, const typename tree_parser_t::sequence& children);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "ast_cache.cpp"
+#endif
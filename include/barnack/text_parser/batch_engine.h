@@ -0,0 +1,134 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <exception>
+#include <string_view>
+
+#include <utils/memory.h>
+#include <utils/containers/regions.h>
+
+#include "tokeniser.h"
+#include "flat_tree.h"
+#include "commands_executor.h"
+#include "execution_context.h"
+#include "region_output.h"
+#include "output_sink.h"
+#include "thread_pool.h"
+
+namespace barnack::text_parser
+	{
+	//Parses and executes many independent documents on a thread pool, sharing one commands_executor and its definitions between all workers.
+	//The registry is only read while processing, so every registered definition must be reentrant.
+	//Each document is executed with its own execution_context, whose output sink and region output write to the document's output.
+	//Each worker keeps its parser and output across documents, so that after the first few documents processing doesn't allocate anymore.
+	template <typename CHAR_T, typename OUTPUT_CHAR_T, typename REGIONS_VALUE_TYPE>
+	class batch_engine
+		{
+		public:
+			using char_t             = CHAR_T;
+			using view_t             = std::basic_string_view<char_t>;
+			using output_char_t      = OUTPUT_CHAR_T;
+			using output_string_t    = std::basic_string<output_char_t>;
+			using regions_value_type = REGIONS_VALUE_TYPE;
+			using regions_t          = utils::containers::regions<regions_value_type>;
+			using region_output_t    = region_output<regions_value_type>;
+
+			struct document_output
+				{
+				output_string_t string;
+				regions_t regions;
+				//Set if parsing or executing the document threw, string and regions are then incomplete.
+				std::exception_ptr error;
+				};
+
+			batch_engine(text_parser::commands_executor<char_t>& commands_executor, size_t threads_count = std::thread::hardware_concurrency()) :
+				commands_executor{commands_executor}, pool{threads_count}
+				{
+				check_reentrant();
+
+				workers_states.reserve(pool.threads_count());
+				for (size_t i{0}; i < pool.threads_count(); i++) { workers_states.push_back(std::make_unique<worker_state>()); }
+				}
+			batch_engine(const batch_engine&) = delete;
+			batch_engine& operator=(const batch_engine&) = delete;
+
+			size_t threads_count() const noexcept { return pool.threads_count(); }
+
+			//Calls callback(index, document_output&) on worker threads, once per input, in no particular order.
+			//The output is reused for the worker's next document, move out of it to keep it.
+			void process(const std::vector<view_t>& inputs, auto&& callback)
+				{
+				check_reentrant();
+				pool.for_each_index(inputs.size(), [&](size_t index, size_t worker_index)
+					{
+					auto& state{*workers_states[worker_index]};
+					process_document(state, inputs[index]);
+					callback(index, state.output);
+					});
+				}
+
+			std::vector<document_output> process(const std::vector<view_t>& inputs)
+				{
+				std::vector<document_output> ret(inputs.size());
+				process(inputs, [&](size_t index, document_output& output) { ret[index] = std::move(output); });
+				return ret;
+				}
+
+		private:
+			struct worker_state
+				{
+				flat_tree_parser<char_t> parser{view_t{}};
+				document_output output;
+				};
+
+			text_parser::commands_executor<char_t>& commands_executor;
+			thread_pool pool;
+			//Pointers, states are written by different threads and shouldn't share cache lines.
+			std::vector<std::unique_ptr<worker_state>> workers_states;
+
+			//Expansions of replacements only resolve registered definitions, so checking all of them covers what replacements execute.
+			//Checked again before every batch, definitions may have been added or have had their cache enabled since construction.
+			void check_reentrant() const
+				{
+				for (const auto& [name, command_definition] : commands_executor.commands_definitions)
+					{
+					if (!command_definition.get().reentrant())
+						{
+						throw std::logic_error{"Command \"" + name + "\" is not reentrant.\n"
+							"Documents are executed concurrently with the same definitions, which must not keep per-execution state."};
+						}
+					}
+				}
+
+			void process_document(worker_state& state, view_t input)
+				{
+				auto& output{state.output};
+				output.string.clear();
+				output.regions = regions_t{};
+				output.error = nullptr;
+
+				try
+					{
+					auto& parser{state.parser};
+					parser.reset(input);
+					parser.symbol_table_ptr = std::addressof(commands_executor.symbols);
+					tokeniser<char_t> tokeniser{input};
+					parser.parse_all(tokeniser);
+
+					string_sink<output_char_t> output_sink{output.string};
+					region_output_t region_output{output.regions};
+					execution_context<char_t> context{commands_executor};
+					context.template set_output<text_parser::output_sink<output_char_t>>(std::addressof(output_sink));
+					context.set_output(std::addressof(region_output));
+					commands_executor.execute(parser.tree.root(), context);
+					}
+				catch (...)
+					{
+					output.error = std::current_exception();
+					}
+				}
+		};
+	}
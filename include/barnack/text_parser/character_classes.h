@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "character_classes_tables.h"
+
+//Character classes used by the tokeniser, as bit masks so that a single lookup answers "does this codepoint belong to any of these classes".
+//The first 256 codepoints are looked up in a flat table, the rest of Unicode in the compact multi-stage tables of character_classes_tables.h.
+namespace barnack::text_parser::character_classes
+	{
+	using mask_t = uint8_t;
+
+	//Unicode White_Space property.
+	inline constexpr mask_t whitespace         {1 << 0};
+	//ASCII digits only.
+	inline constexpr mask_t digit              {1 << 1};
+	//[A-Za-z_]
+	inline constexpr mask_t identifier_start   {1 << 2};
+	//[A-Za-z0-9_]
+	inline constexpr mask_t identifier_continue{1 << 3};
+	//XID_Start and '_'.
+	inline constexpr mask_t xid_start          {1 << 4};
+	//XID_Continue.
+	inline constexpr mask_t xid_continue       {1 << 5};
+
+	inline constexpr std::array<mask_t, 256> latin1{[]()
+		{
+		std::array<mask_t, 256> ret{};
+		const auto set{[&ret](unsigned first, unsigned last, mask_t mask) { for (unsigned c{first}; c <= last; c++) { ret[c] |= mask; } }};
+
+		set(0x09, 0x0D, whitespace);
+		set(0x20, 0x20, whitespace);
+		set(0x85, 0x85, whitespace);
+		set(0xA0, 0xA0, whitespace);
+
+		set('0', '9', digit | identifier_continue | xid_continue);
+		set('A', 'Z', identifier_start | identifier_continue | xid_start | xid_continue);
+		set('a', 'z', identifier_start | identifier_continue | xid_start | xid_continue);
+		set('_', '_', identifier_start | identifier_continue | xid_start | xid_continue);
+
+		set(0xAA, 0xAA, xid_start | xid_continue);
+		set(0xB5, 0xB5, xid_start | xid_continue);
+		set(0xB7, 0xB7,             xid_continue);
+		set(0xBA, 0xBA, xid_start | xid_continue);
+		set(0xC0, 0xD6, xid_start | xid_continue);
+		set(0xD8, 0xF6, xid_start | xid_continue);
+		set(0xF8, 0xFF, xid_start | xid_continue);
+		return ret;
+		}()};
+
+	constexpr mask_t of(char32_t codepoint) noexcept
+		{
+		if (codepoint < latin1.size()) { return latin1[codepoint]; }
+		if (codepoint > 0x10FFFF) { return 0; }
+
+		constexpr size_t blocks_per_row{size_t{1} << (tables::stage_0_shift - tables::stage_1_shift)};
+		constexpr size_t bytes_per_block{(size_t{1} << tables::stage_1_shift) / 4};
+		constexpr std::array<mask_t, 4> masks{0, whitespace, xid_continue, xid_start | xid_continue};
+
+		const size_t row  {tables::stage_0[codepoint >> tables::stage_0_shift]};
+		const size_t block{tables::stage_1[row * blocks_per_row + ((codepoint >> tables::stage_1_shift) & (blocks_per_row - 1))]};
+		const size_t index{codepoint & ((size_t{1} << tables::stage_1_shift) - 1)};
+		const uint8_t byte{tables::stage_2[block * bytes_per_block + index / 4]};
+		return masks[(byte >> ((index % 4) * 2)) & 0b11];
+		}
+	}
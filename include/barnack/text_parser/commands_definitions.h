@@ -9,7 +9,14 @@
 #include <utils/containers/regions.h>
 
 #include "tree_parser.h"
+#include "flat_tree.h"
 #include "commands_executor.h"
+#include "replacement_template.h"
+#include "expansion_cache.h"
+#include "execution_context.h"
+#include "region_output.h"
+#include "output_sink.h"
+#include "transcode.h"
 
 namespace barnack::text_parser::command_definition
 	{
@@ -19,6 +26,7 @@ namespace barnack::text_parser::command_definition
 		using char_t = typename base<CHAR_T>::char_t;
 
 		virtual std::string name() const noexcept final override { return "comment"; }
+		virtual bool reentrant() const noexcept override { return true; }
 		};
 
 	template <typename CHAR_T, typename OUTPUT_CHAR_T>
@@ -27,17 +35,30 @@ namespace barnack::text_parser::command_definition
 		using char_t = typename base<CHAR_T>::char_t;
 		using output_char_t = OUTPUT_CHAR_T;
 		using output_string_t = std::basic_string<output_char_t>;
+		using output_sink_t   = output_sink<output_char_t>;
 
-		utils::observer_ptr<output_string_t> output_string_ptr{nullptr};
+		virtual bool reentrant() const noexcept override { return true; }
 
-		virtual void on_child(const typename tree_parser<char_t>::command& command, const typename tokeniser<char_t>::range& child_range) final override
-			{
-			if (output_string_ptr)
+		virtual void on_child(const typename tree_parser<char_t>::command     & command, const typename tokeniser<char_t>::range     & child_range, execution_context<char_t>& context) final override { output(child_range.string(), context); }
+		virtual void on_child(const typename flat_tree  <char_t>::command_view& command, const typename flat_tree<char_t>::range_view& child_range, execution_context<char_t>& context) final override { output(child_range.string(), context); }
+
+		private:
+			void output(std::basic_string_view<char_t> child_string, execution_context<char_t>& context) const
 				{
-				auto& output_string{*output_string_ptr};
-				output_string += utils::string::cast<output_char_t>(child_range.string());
+				if (const auto output_sink_ptr{context.template output<output_sink_t>()})
+					{
+					//Same characters are passed through as a view of the source, which sinks may keep instead of copying.
+					if constexpr (std::same_as<char_t, output_char_t>) { output_sink_ptr->append(child_string); }
+					else
+						{
+						//Reused by every raw range the thread outputs, so transcoding doesn't allocate once it's grown enough.
+						thread_local output_string_t transcoded;
+						transcoded.clear();
+						transcode::append(child_string, transcoded);
+						output_sink_ptr->append(transcoded);
+						}
+					}
 				}
-			}
 		};
 
 	template <typename CHAR_T, typename OUTPUT_CHAR_T>
@@ -48,15 +69,19 @@ namespace barnack::text_parser::command_definition
 
 		virtual std::string name() const noexcept final override { return {}; }
 
-		virtual void validate(const typename tree_parser<char_t>::command& command) const override 
-			{
-			if (!command.parameters.empty())
+		virtual void validate(const typename tree_parser<char_t>::command     & command, const execution_context<char_t>& context) const override { validate_command(command); }
+		virtual void validate(const typename flat_tree  <char_t>::command_view& command, const execution_context<char_t>& context) const override { validate_command(command); }
+
+		private:
+			void validate_command(const auto& command) const
 				{
-				throw std::runtime_error{"Error parsing root command\n"
-					"Expects no parameters.\n"
-					"Command at: " + command.name.begin.to_string()};
+				if (!command.parameters.empty())
+					{
+					throw std::runtime_error{"Error parsing root command\n"
+						"Expects no parameters.\n"
+						"Command at: " + command.name.begin.to_string()};
+					}
 				}
-			}
 		};
 
 	template <typename CHAR_T, typename OUTPUT_CHAR_T>
@@ -67,15 +92,19 @@ namespace barnack::text_parser::command_definition
 
 		virtual std::string name() const noexcept final override { return "output_body"; }
 
-		virtual void validate(const typename tree_parser<char_t>::command& command) const override
-			{
-			if (!command.parameters.empty())
+		virtual void validate(const typename tree_parser<char_t>::command     & command, const execution_context<char_t>& context) const override { validate_command(command); }
+		virtual void validate(const typename flat_tree  <char_t>::command_view& command, const execution_context<char_t>& context) const override { validate_command(command); }
+
+		private:
+			void validate_command(const auto& command) const
 				{
-				throw std::runtime_error{"Error parsing output_body command\n"
-					"Expects no parameters.\n"
-					"Command at: " + command.name.begin.to_string()};
+				if (!command.parameters.empty())
+					{
+					throw std::runtime_error{"Error parsing output_body command\n"
+						"Expects no parameters.\n"
+						"Command at: " + command.name.begin.to_string()};
+					}
 				}
-			}
 		};
 
 	struct runtime_checked_parameters
@@ -90,7 +119,10 @@ namespace barnack::text_parser::command_definition
 				};
 			struct identifier
 				{
+				//Any identifier if empty.
 				std::vector<std::string> one_of;
+				//Filled by intern_symbols for each executor's table, lets validation compare symbols instead of strings.
+				per_symbol_table<std::vector<symbol_table::symbol_t>> one_of_symbols{};
 				};
 			struct string {};
 			//using command = observer_ptr<text_parser>::command ???
@@ -124,10 +156,32 @@ namespace barnack::text_parser::command_definition
 		parameters_type_variant parameters{parameters_type::any{}};
 		body_requirement body{body_requirement::optional};
 
+		void intern_symbols(symbol_table& symbols)
+			{
+			if (!std::holds_alternative<typename parameters_type::exact>(parameters)) { return; }
+
+			for (auto& parameter_variant : std::get<parameters_type::exact>(parameters))
+				{
+				if (!std::holds_alternative<typename parameter_type::identifier>(parameter_variant)) { continue; }
+
+				auto& identifier{std::get<parameter_type::identifier>(parameter_variant)};
+				auto& one_of_symbols{identifier.one_of_symbols[symbols]};
+				one_of_symbols.clear();
+				for (const auto& name : identifier.one_of) { one_of_symbols.push_back(symbols.intern(name)); }
+				}
+			}
+
+		//Command can be either a tree_parser<char_t>::command or a flat_tree<char_t>::command_view.
+		//symbols_ptr is the table the command was parsed with, identifiers are compared as strings without it.
 		template <typename char_t>
-		void validate(const std::string& command_prototype_name, const typename tree_parser<char_t>::command& command) const
+		void validate(const std::string& command_prototype_name, const auto& command, utils::observer_ptr<const symbol_table> symbols_ptr = nullptr) const
 			{
-			if (utils::string::cast<char>(command.name.string()) != command_prototype_name)
+			const bool name_matches{[&]()
+				{
+				if constexpr (std::same_as<char_t, char>) { return command.name.string() == command_prototype_name; }
+				else { return transcode::to<char>(command.name.string()) == command_prototype_name; }
+				}()};
+			if (!name_matches)
 				{ 
 				throw std::runtime_error{"Error parsing command. Name does not match.\n"
 					"Expected: \"" + command_prototype_name + "\", received: \"" + utils::string::cast<char>(command.name.string()) + "\"\n"
@@ -150,9 +204,7 @@ namespace barnack::text_parser::command_definition
 						}
 					else if (std::holds_alternative<typename parameter_type::number>(parameter_variant))
 						{
-						const tokeniser<char_t> tokeniser{input_parameter.string()};
-						const auto ret{tokeniser.next_number(tokeniser.begin_with_info())};
-						if (ret.begin.it != input_parameter.begin.it || ret.end.it != input_parameter.end.it)
+						if (input_parameter.kind != tokeniser<char_t>::token_kind::number)
 							{
 							throw std::runtime_error{"Error parsing command \"" + command_prototype_name + "\"\n"
 								"Expects number as parameter #" + std::to_string(i) + ",\n"
@@ -160,12 +212,19 @@ namespace barnack::text_parser::command_definition
 								"Command at: " + command.name.begin.to_string() + "\n"
 								"Parameter at: " + input_parameter.begin.to_string()};
 							}
+						const auto& number{std::get<parameter_type::number>(parameter_variant)};
+						if (input_parameter.number() < number.min || input_parameter.number() > number.max)
+							{
+							throw std::runtime_error{"Error parsing command \"" + command_prototype_name + "\"\n"
+								"Expects number between " + std::to_string(number.min) + " and " + std::to_string(number.max) + " as parameter #" + std::to_string(i) + ",\n"
+								"Received \"" + utils::string::cast<char>(input_parameter.string()) + "\" instead.\n"
+								"Command at: " + command.name.begin.to_string() + "\n"
+								"Parameter at: " + input_parameter.begin.to_string()};
+							}
 						}
 					else if (std::holds_alternative<typename parameter_type::identifier>(parameter_variant))
 						{
-						const tokeniser<char_t> tokeniser{input_parameter.string()};
-						const auto ret{tokeniser.next_identifier(tokeniser.begin_with_info())};
-						if (ret.begin.it != input_parameter.begin.it || ret.end.it != input_parameter.end.it)
+						if (input_parameter.kind != tokeniser<char_t>::token_kind::identifier)
 							{
 							throw std::runtime_error{"Error parsing command \"" + command_prototype_name + "\"\n"
 								"Expects identifier as parameter #" + std::to_string(i) + ",\n"
@@ -173,11 +232,41 @@ namespace barnack::text_parser::command_definition
 								"Command at: " + command.name.begin.to_string() + "\n"
 								"Parameter at: " + input_parameter.begin.to_string()};
 							}
+
+						const auto& identifier{std::get<parameter_type::identifier>(parameter_variant)};
+						if (!identifier.one_of.empty())
+							{
+							const auto one_of_symbols_ptr{symbols_ptr ? identifier.one_of_symbols.find(*symbols_ptr) : nullptr};
+							const bool compare_symbols{input_parameter.symbol != symbol_table::none && one_of_symbols_ptr && one_of_symbols_ptr->size() == identifier.one_of.size()};
+							const bool found
+								{
+								compare_symbols ?
+									std::ranges::find(*one_of_symbols_ptr, input_parameter.symbol) != one_of_symbols_ptr->end() :
+									std::ranges::find(identifier.one_of, transcode::to<char>(input_parameter.string())) != identifier.one_of.end()
+								};
+							if (!found)
+								{
+								std::string one_of_list;
+								for (const auto& name : identifier.one_of) { one_of_list += (one_of_list.empty() ? "\"" : ", \"") + name + "\""; }
+
+								throw std::runtime_error{"Error parsing command \"" + command_prototype_name + "\"\n"
+									"Expects one of " + one_of_list + " as parameter #" + std::to_string(i) + ",\n"
+									"Received \"" + utils::string::cast<char>(input_parameter.string()) + "\" instead.\n"
+									"Command at: " + command.name.begin.to_string() + "\n"
+									"Parameter at: " + input_parameter.begin.to_string()};
+								}
+							}
 						}
 					else if (std::holds_alternative<typename parameter_type::string>(parameter_variant))
 						{
-						//TODO check string
-						assert(false);
+						if (input_parameter.kind != tokeniser<char_t>::token_kind::string)
+							{
+							throw std::runtime_error{"Error parsing command \"" + command_prototype_name + "\"\n"
+								"Expects string as parameter #" + std::to_string(i) + ",\n"
+								"Received \"" + utils::string::cast<char>(input_parameter.string()) + "\" instead.\n"
+								"Command at: " + command.name.begin.to_string() + "\n"
+								"Parameter at: " + input_parameter.begin.to_string()};
+							}
 						}
 					}
 				}
@@ -229,7 +318,7 @@ namespace barnack::text_parser::command_definition
 				generate_replacement_parameters_ranges(command_name);
 				}
 
-			std::basic_string<char_t> generate_string(const typename tree_parser<char_t>::command& command) const noexcept
+			std::basic_string<char_t> generate_string(const auto& command) const noexcept
 				{
 				std::basic_string<char_t> ret;
 				
@@ -248,7 +337,7 @@ namespace barnack::text_parser::command_definition
 				return ret;
 				}
 				
-			void validate(const std::string& command_prototype_name, const typename tree_parser<char_t>::command& command) const
+			void validate(const std::string& command_prototype_name, const auto& command) const
 				{
 				if (command.parameters.size() < replacement_string_parameters_count)
 					{
@@ -274,7 +363,7 @@ namespace barnack::text_parser::command_definition
 				
 						if (second_codepoint_with_range.codepoint == U'#')
 							{
-							const auto number_range{tokeniser.next_number(second_codepoint_with_range.range.end)};
+							const auto number_range{tokeniser.next_run(second_codepoint_with_range.range.end, character_classes::digit)};
 							if (number_range.empty())
 								{
 								throw std::runtime_error{"Error validating command \"" + command_name + "\"\n"
@@ -326,7 +415,8 @@ namespace barnack::text_parser::command_definition
 				inner_name{create_info.name},
 				runtime_checked_parameters{create_info.parameters, create_info.body},
 				replacement_piece_before_body{utils::string::cast<char>(create_info.name), create_info.replacement_string_before_body_prototype},
-				replacement_piece_after_body {utils::string::cast<char>(create_info.name), create_info.replacement_string_after_body_prototype }
+				replacement_piece_after_body {utils::string::cast<char>(create_info.name), create_info.replacement_string_after_body_prototype },
+				replacement_template{replacement_piece_before_body, replacement_piece_after_body}
 				{
 				if (std::holds_alternative<runtime_checked_parameters::parameters_type::any>(runtime_checked_parameters.parameters))
 					{
@@ -368,45 +458,87 @@ namespace barnack::text_parser::command_definition
 			runtime_checked_parameters runtime_checked_parameters;
 			replacement_piece<char_t> replacement_piece_before_body;
 			replacement_piece<char_t> replacement_piece_after_body;
+			//Used instead of generating and parsing the replacement strings whenever the invocation's parameters allow it.
+			text_parser::replacement_template<char_t> replacement_template;
 
 		public:
-			utils::observer_ptr<commands_executor<char_t>> commands_executor_ptr{nullptr};
+			//Opt-in, enabled by setting its capacity. Invocations the replacement template can't bind are then generated and parsed once per distinct parameters.
+			//Every invocation updates the cache's recency order, the definition isn't reentrant while it's enabled.
+			text_parser::expansion_cache<char_t> expansion_cache;
 		
 			virtual std::string name() const noexcept final override
 				{
 				return inner_name;
 				}
 
-			virtual void validate(const typename tree_parser<char_t>::command& command) const override
+			virtual void validate(const typename tree_parser<char_t>::command     & command, const execution_context<char_t>& context) const override { validate_command(command, context); }
+			virtual void validate(const typename flat_tree  <char_t>::command_view& command, const execution_context<char_t>& context) const override { validate_command(command, context); }
+			virtual bool execute_child_commands() const noexcept override { return false; }
+			virtual bool needs_whole_body      () const noexcept override { return true ; }
+			virtual bool reentrant             () const noexcept override { return expansion_cache.capacity == 0; }
+			virtual bool executes_other_definitions() const noexcept override { return true; }
+			virtual void intern_symbols(symbol_table& symbols) override
+				{
+				runtime_checked_parameters.intern_symbols(symbols);
+				replacement_template      .intern_symbols(symbols);
+				}
+			
+
+			virtual void on_begin(const typename tree_parser<char_t>::command& command, execution_context<char_t>& context) final override
+				{
+				execute_replacement(command, command.children, context);
+				}
+			virtual void on_begin(const typename flat_tree<char_t>::command_view& command, execution_context<char_t>& context) final override
+				{
+				//The expansion is a tree_parser tree and hooks are typed by representation, so the body is converted to be spliced into it.
+				const auto children{command.tree_ptr->to_sequence(command.children)};
+				execute_replacement(command, children, context);
+				}
+
+		private:
+			using expansion_t = typename text_parser::expansion_cache<char_t>::expansion;
+
+			void validate_command(const auto& command, const execution_context<char_t>& context) const
 				{
-				runtime_checked_parameters   .validate<char_t>(inner_name, command);
+				const utils::observer_ptr<const symbol_table> symbols_ptr{context.commands_executor_ptr ? std::addressof(context.commands_executor_ptr->symbols) : nullptr};
+				runtime_checked_parameters   .validate<char_t>(inner_name, command, symbols_ptr);
 				replacement_piece_before_body.validate        (inner_name, command);
 				replacement_piece_after_body .validate        (inner_name, command);
 				}
-			virtual bool execute_child_commands() const noexcept override { return false; }
-			
 
-			virtual void on_begin(const typename tree_parser<char_t>::command& command) final override
+			//The body is spliced rather than copied, it outlives the replacement's execution.
+			void execute_replacement(const auto& command, const typename tree_parser<char_t>::sequence& body, execution_context<char_t>& context)
 				{
-				if (!commands_executor_ptr) { throw std::logic_error{"commands_executor_ptr must be assigned before executing an executor which contains this command."}; }
+				if (!context.commands_executor_ptr) { throw std::logic_error{"The execution context must have a commands_executor to execute a runtime defined replacement."}; }
 				try
 					{
-					const auto generated_string_before_body{replacement_piece_before_body.generate_string(command)};
-					const auto generated_string_after_body {replacement_piece_after_body .generate_string(command)};
-					
-					tokeniser<char_t> tokeniser_before_body{generated_string_before_body};
-					tokeniser<char_t> tokeniser_after_body {generated_string_after_body };
-						
-					tree_parser<char_t> parser;
-					parser.parse_all(tokeniser_before_body);
-					
-					auto& top_sequence{*parser.sequences_stack.top()};
-					top_sequence.insert(top_sequence.end(), command.children.begin(), command.children.end());
-					
-					parser.parse_all(tokeniser_after_body);
-					
-					commands_executor<char_t>& commands_executor{*commands_executor_ptr};
-					commands_executor.execute(parser.root);
+					commands_executor<char_t>& commands_executor{*context.commands_executor_ptr};
+					const bool has_body{!body.empty()};
+
+					if (replacement_template.can_bind(command))
+						{
+						commands_executor.execute(replacement_template.bind(command, commands_executor.symbols, [&](typename tree_parser<char_t>::sequence& sequence)
+							{
+							if (has_body) { sequence.emplace_back(typename tree_parser<char_t>::splice{std::addressof(body)}); }
+							}), context);
+						return;
+						}
+
+					std::shared_ptr<const expansion_t> expansion_ptr;
+					if (expansion_cache.capacity > 0)
+						{
+						auto key{expansion_cache.key(command, has_body)};
+						expansion_ptr = expansion_cache.find(key, commands_executor.symbols);
+						if (!expansion_ptr)
+							{
+							expansion_ptr = expand(command, has_body, commands_executor.symbols);
+							expansion_cache.insert(std::move(key), expansion_ptr);
+							}
+						}
+					else { expansion_ptr = expand(command, has_body, commands_executor.symbols); }
+
+					//Held until the execution is done, the instance refers to its strings even if the cache evicts it meanwhile.
+					commands_executor.execute(expansion_ptr->instantiate(body), context);
 					}
 				catch (const std::exception& e)
 					{
@@ -415,6 +547,31 @@ namespace barnack::text_parser::command_definition
 						"Errors parsing the generated string.\n" + e.what()};
 					}
 				}
+
+			//Generates and parses the replacement strings, leaving an unassigned splice where the body goes.
+			std::shared_ptr<expansion_t> expand(const auto& command, bool has_body, const symbol_table& symbols) const
+				{
+				auto ret{std::make_shared<expansion_t>()};
+				ret->generated_string_before_body = replacement_piece_before_body.generate_string(command);
+				ret->generated_string_after_body  = replacement_piece_after_body .generate_string(command);
+
+				tokeniser<char_t> tokeniser_before_body{ret->generated_string_before_body};
+				tokeniser<char_t> tokeniser_after_body {ret->generated_string_after_body };
+
+				tree_parser<char_t> parser;
+				parser.symbol_table_ptr = std::addressof(symbols);
+				ret->symbols_ptr        = std::addressof(symbols);
+				parser.parse_all(tokeniser_before_body);
+
+				if (has_body) { parser.sequences_stack.top()->emplace_back(typename tree_parser<char_t>::splice{}); }
+
+				parser.parse_all(tokeniser_after_body);
+
+				ret->root = std::move(parser.root);
+				ret->strings = std::move(parser.strings);
+				ret->find_body_splice();
+				return ret;
+				}
 		};
 
 
@@ -424,46 +581,49 @@ namespace barnack::text_parser::command_definition
 		using char_t          = typename output_body_base<CHAR_T, OUTPUT_CHAR_T>::char_t;
 		using output_char_t   = typename output_body_base<CHAR_T, OUTPUT_CHAR_T>::output_char_t;
 		using output_string_t = typename output_body_base<CHAR_T, OUTPUT_CHAR_T>::output_string_t;
+		using output_sink_t   = typename output_body_base<CHAR_T, OUTPUT_CHAR_T>::output_sink_t;
 
 		using regions_value_type = REGIONS_VALUE_TYPE;
 		using regions_t = utils::containers::regions<regions_value_type>;
 
-		using output_body_base<CHAR_T, OUTPUT_CHAR_T>::output_string_ptr;
+		using region_output_t = region_output<regions_value_type>;
 
-		utils::observer_ptr<regions_t> output_region_ptr{nullptr};
-		regions_value_type previous_value;
+		//Regions are written to the context's region_output, which keeps the values to restore when regions end.
+		virtual bool reentrant() const noexcept override { return true; }
 
-		virtual regions_value_type region_value(const typename tree_parser<char_t>::command& command) = 0;
-	
-		virtual void on_begin(const typename tree_parser<char_t>::command& command) final override
+		virtual regions_value_type region_value(const typename tree_parser<char_t>::command& command) const = 0;
+		//Defaults to the tree_parser overload on a copy of the command without its children, override it to read the view without copying.
+		virtual regions_value_type region_value(const typename flat_tree<char_t>::command_view& command) const
 			{
-			if (output_region_ptr && output_string_ptr)
-				{
-				auto& output_region{*output_region_ptr};
-				auto& output_string{*output_string_ptr};
-				const auto last_slot = output_region.at_element_index(output_string.size());
-				previous_value = last_slot.value();
-
-				output_region.add(region_value(command), utils::containers::region::create::from(output_string.size()));
-				}
+			return region_value(command.tree_ptr->to_command(command, false));
 			}
 	
-		virtual void on_end(const typename tree_parser<char_t>::command& command) final override
-			{
-			if (output_region_ptr && output_string_ptr)
+		virtual void on_begin(const typename tree_parser<char_t>::command     & command, execution_context<char_t>& context) final override { begin_region(command, context); }
+		virtual void on_begin(const typename flat_tree  <char_t>::command_view& command, execution_context<char_t>& context) final override { begin_region(command, context); }
+		virtual void on_end  (const typename tree_parser<char_t>::command     & command, execution_context<char_t>& context) final override { end_region(context); }
+		virtual void on_end  (const typename flat_tree  <char_t>::command_view& command, execution_context<char_t>& context) final override { end_region(context); }
+
+		private:
+			void begin_region(const auto& command, execution_context<char_t>& context) const
 				{
-				auto& output_string{*output_string_ptr};
-				auto& output_region{*output_region_ptr};
-				output_region.add(previous_value, utils::containers::region::create::from(output_string.size()));
+				const auto output_sink_ptr  {context.template output<output_sink_t  >()};
+				const auto output_region_ptr{context.template output<region_output_t>()};
+				if (output_region_ptr && output_sink_ptr)
+					{
+					output_region_ptr->begin(region_value(command), output_sink_ptr->size());
+					}
 				}
-			}
-		};
-
-
-
-
-
 
+			void end_region(execution_context<char_t>& context) const
+				{
+				const auto output_sink_ptr  {context.template output<output_sink_t  >()};
+				const auto output_region_ptr{context.template output<region_output_t>()};
+				if (output_region_ptr && output_sink_ptr)
+					{
+					output_region_ptr->end(output_sink_ptr->size());
+					}
+				}
+		};
 
 	template <typename CHAR_T, typename OUTPUT_CHAR_T>
 	struct unicode_codepoint : base<CHAR_T>
@@ -471,44 +631,52 @@ namespace barnack::text_parser::command_definition
 		using char_t = typename base<CHAR_T>::char_t;
 		using output_char_t   = OUTPUT_CHAR_T;
 		using output_string_t = std::basic_string<output_char_t>;
-
-		utils::observer_ptr<output_string_t> output_string_ptr{nullptr};
+		using output_sink_t   = output_sink<output_char_t>;
 
 		virtual std::string name() const noexcept final override { return "unicode_codepoint"; }
+		virtual bool reentrant() const noexcept override { return true; }
+		//Only to validate that there is no body.
+		virtual bool needs_whole_body() const noexcept final override { return true; }
 
-		virtual void on_begin(const typename tree_parser<char_t>::command& command) final override
-			{
-			const auto& parameter{command.parameters[0]};
-			const std::basic_string_view<char_t> hex_number_string{parameter.begin.it + 1/*skip starting 'c'*/, parameter.end.it};
-			const char32_t codepoint{utils::string::parse_codepoint(hex_number_string)};
-			const std::basic_string<output_char_t> codepoint_as_string{utils::string::codepoint_to_string<output_char_t>(codepoint)};
-			
-			if (output_string_ptr)
-				{
-				auto& output_string{*output_string_ptr};
-				output_string += codepoint_as_string;
-				}
-			}
+		virtual void on_begin(const typename tree_parser<char_t>::command     & command, execution_context<char_t>& context) final override { output_codepoint(command, context); }
+		virtual void on_begin(const typename flat_tree  <char_t>::command_view& command, execution_context<char_t>& context) final override { output_codepoint(command, context); }
 
-		virtual void validate(const typename tree_parser<char_t>::command& command) const override
-			{
-			const std::runtime_error error{"Error parsing \"unicode_codepoint\" command\n"
-					"Expects an unicode escape sequence (without prior backslash) as parameter and expects no body.\n"
-					"Example \"\\unicode_codepoint(u1F604);\" for 😄.\n"
-					"Command at: " + command.name.begin.to_string()};
+		virtual void validate(const typename tree_parser<char_t>::command     & command, const execution_context<char_t>& context) const override { validate_command(command); }
+		virtual void validate(const typename flat_tree  <char_t>::command_view& command, const execution_context<char_t>& context) const override { validate_command(command); }
 
-			if (command.parameters.size() != 1 || !command.children.empty())
+		private:
+			void output_codepoint(const auto& command, execution_context<char_t>& context) const
 				{
-				throw error;
+				const auto& parameter{command.parameters[0]};
+				const std::basic_string_view<char_t> hex_number_string{parameter.begin.it + 1/*skip starting 'c'*/, parameter.end.it};
+				const char32_t codepoint{utils::string::parse_codepoint(hex_number_string)};
+				const std::basic_string<output_char_t> codepoint_as_string{utils::string::codepoint_to_string<output_char_t>(codepoint)};
+				
+				if (const auto output_sink_ptr{context.template output<output_sink_t>()})
+					{
+					output_sink_ptr->append(codepoint_as_string);
+					}
 				}
-			const auto& parameter{command.parameters[0]};
-			text_parser::tokeniser<char_t> tokeniser{parameter.string()};
-			const typename text_parser::tokeniser<char_t>::codepoint_with_range first_codepoint{tokeniser.next_codepoint(tokeniser.begin_with_info())};
-			if (first_codepoint.codepoint != U'u')
+
+			void validate_command(const auto& command) const
 				{
-				throw error;
+				const std::runtime_error error{"Error parsing \"unicode_codepoint\" command\n"
+						"Expects an unicode escape sequence (without prior backslash) as parameter and expects no body.\n"
+						"Example \"\\unicode_codepoint(u1F604);\" for 😄.\n"
+						"Command at: " + command.name.begin.to_string()};
+
+				if (command.parameters.size() != 1 || !command.children.empty())
+					{
+					throw error;
+					}
+				const auto& parameter{command.parameters[0]};
+				text_parser::tokeniser<char_t> tokeniser{parameter.string()};
+				const typename text_parser::tokeniser<char_t>::codepoint_with_range first_codepoint{tokeniser.next_codepoint(tokeniser.begin_with_info())};
+				if (first_codepoint.codepoint != U'u')
+					{
+					throw error;
+					}
 				}
-			}
 		};
 	}
 
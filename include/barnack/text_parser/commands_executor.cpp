@@ -1,42 +1,129 @@
 #include "commands_executor.h"
 
+#include <algorithm>
+
+#include "transcode.h"
+
 namespace barnack::text_parser
 	{
 	template <typename char_t>
-	void commands_executor<char_t>::execute(const input_command_t& input_command)
+	command_definition::base<char_t>& commands_executor<char_t>::find_command_definition(view_t input_command_name, symbol_table::symbol_t input_command_symbol, auto&& position_to_string)
 		{
-		const std::string input_command_name_utf8{utils::string::cast<char>(input_command.name.string())};
-		auto command_definition_it{commands_definitions.find(input_command_name_utf8)};
-		if (command_definition_it == commands_definitions.end())
+		const auto command_definition_ptr{try_find_command_definition(input_command_name, input_command_symbol)};
+		if (!command_definition_ptr)
 			{
-			throw std::runtime_error{"Error resolving command \"" + utils::string::cast<char>(input_command.name.string()) + "\"\n"
+			throw std::runtime_error{"Error resolving command \"" + utils::string::cast<char>(input_command_name) + "\"\n"
 				"Command not found.\n"
-				"Command at: " + input_command.name.begin.to_string()};
+				"Command at: " + position_to_string()};
 			}
+		return *command_definition_ptr;
+		}
 
-		auto& command_definition{command_definition_it->second.get()};
-		command_definition.validate(input_command);
+	template <typename char_t>
+	command_definition::base<char_t>& commands_executor<char_t>::find_command_definition(const typename tokeniser<char_t>::range& input_command_name, symbol_table::symbol_t input_command_symbol)
+		{
+		return find_command_definition(input_command_name.string(), input_command_symbol, [&]() { return input_command_name.begin.to_string(); });
+		}
 
-		command_definition.on_begin(input_command);
+	template <typename char_t>
+	command_definition::base<char_t>& commands_executor<char_t>::find_command_definition(const typename flat_tree<char_t>::range_view& input_command_name, symbol_table::symbol_t input_command_symbol)
+		{
+		return find_command_definition(input_command_name.string(), input_command_symbol, [&]() { return input_command_name.begin.to_string(); });
+		}
 
-		for (const auto& child : input_command.children)
+	template <typename char_t>
+	utils::observer_ptr<command_definition::base<char_t>> commands_executor<char_t>::try_find_command_definition(view_t input_command_name, symbol_table::symbol_t input_command_symbol)
+		{
+		if (input_command_symbol < commands_definitions_by_symbol.size() && commands_definitions_by_symbol[input_command_symbol])
 			{
-			std::visit([&command_definition, input_command](const auto& child) { command_definition.on_child(input_command, child); }, child);
+			return commands_definitions_by_symbol[input_command_symbol];
+			}
+
+		const std::string input_command_name_utf8{transcode::to<char>(input_command_name)};
+		auto command_definition_it{commands_definitions.find(input_command_name_utf8)};
+		if (command_definition_it == commands_definitions.end()) { return nullptr; }
+		return std::addressof(command_definition_it->second.get());
+		}
+
+	template <typename char_t>
+	bool commands_executor<char_t>::all_reentrant() const noexcept
+		{
+		return std::ranges::all_of(commands_definitions, [](const auto& entry) { return entry.second.get().reentrant(); });
+		}
+
+	template <typename char_t>
+	void commands_executor<char_t>::execute(const input_command_t& input_command, execution_context<char_t>& context)
+		{
+		auto& command_definition{find_command_definition(input_command.name, input_command.name_symbol)};
+		command_definition.validate(input_command, context);
 
-			if (command_definition.execute_child_commands())
+		command_definition.on_begin(input_command, context);
+
+		tree_parser<char_t>::for_each_element(input_command.children, [&](const typename tree_parser<char_t>::sequence_element& child)
+			{
+			if (const auto child_command_ptr{std::get_if<input_command_t>(&child)})
 				{
-				if (std::holds_alternative<input_command_t>(child))
+				const input_command_t& child_command{*child_command_ptr};
+				command_definition.on_child(input_command, child_command, context);
+
+				if (command_definition.execute_child_commands())
 					{
-					const input_command_t& child_command{std::get<input_command_t>(child)};
-					execute(child_command);
+					execute(child_command, context);
 					}
 				}
+			else
+				{
+				command_definition.on_child(input_command, std::get<typename tokeniser<char_t>::range>(child), context);
+				}
+			});
+
+		command_definition.on_end(input_command, context);
+		}
+
+	template <typename char_t>
+	void commands_executor<char_t>::execute(const input_command_view_t& input_command, execution_context<char_t>& context)
+		{
+		auto& command_definition{find_command_definition(input_command.name, input_command.name_symbol)};
+		command_definition.validate(input_command, context);
+
+		command_definition.on_begin(input_command, context);
+
+		for (const auto& child : input_command.children)
+			{
+			if (child.is_command())
+				{
+				const input_command_view_t child_command{child.command()};
+				command_definition.on_child(input_command, child_command, context);
+
+				if (command_definition.execute_child_commands())
+					{
+					execute(child_command, context);
+					}
+				}
+			else
+				{
+				command_definition.on_child(input_command, child.range(), context);
+				}
 			}
 
-		command_definition.on_end(input_command);
+		command_definition.on_end(input_command, context);
+		}
+
+	template <typename char_t>
+	void commands_executor<char_t>::execute(const input_command_t& input_command)
+		{
+		execution_context<char_t> context{*this};
+		execute(input_command, context);
+		}
+
+	template <typename char_t>
+	void commands_executor<char_t>::execute(const input_command_view_t& input_command)
+		{
+		execution_context<char_t> context{*this};
+		execute(input_command, context);
 		}
 
 	template class commands_executor<char16_t>;
 	template class commands_executor<char8_t>;
 	template class commands_executor<char>;
-	}
\ No newline at end of file
+	}
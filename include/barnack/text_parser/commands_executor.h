@@ -1,8 +1,13 @@
 #pragma once
 
+#include <vector>
 #include <unordered_map>
 #include <utils/string.h>
+#include <utils/memory.h>
 #include "tree_parser.h"
+#include "flat_tree.h"
+#include "symbol_table.h"
+#include "execution_context.h"
 
 namespace barnack::text_parser
 	{
@@ -15,12 +20,31 @@ namespace barnack::text_parser
 
 			virtual std::string name() const noexcept = 0;
 
-			virtual void validate(const typename tree_parser<char_t>::command& command) const {}
-			virtual void on_begin(const typename tree_parser<char_t>::command& command) {}
-			virtual void on_end  (const typename tree_parser<char_t>::command& command) {}
-			virtual void on_child(const typename tree_parser<char_t>::command& command, const typename tree_parser<char_t>::command& child_command) {}
-			virtual void on_child(const typename tree_parser<char_t>::command& command, const typename tokeniser  <char_t>::range  & child_range  ) {}
+			//Hooks write to the outputs of the context they're given, a definition keeps no state of its own across a command's hooks.
+			virtual void validate(const typename tree_parser<char_t>::command& command, const execution_context<char_t>& context) const {}
+			virtual void on_begin(const typename tree_parser<char_t>::command& command, execution_context<char_t>& context) {}
+			virtual void on_end  (const typename tree_parser<char_t>::command& command, execution_context<char_t>& context) {}
+			virtual void on_child(const typename tree_parser<char_t>::command& command, const typename tree_parser<char_t>::command& child_command, execution_context<char_t>& context) {}
+			virtual void on_child(const typename tree_parser<char_t>::command& command, const typename tokeniser  <char_t>::range  & child_range  , execution_context<char_t>& context) {}
 			virtual bool execute_child_commands() const noexcept { return true; }
+			//When executing while parsing (executing_parser), hooks receive commands without their children.
+			//Definitions that need to see the whole body return true here, and are executed only once their body is entirely parsed.
+			virtual bool needs_whole_body() const noexcept { return false; }
+			//Called when added to a commands_executor, to intern the identifiers the definition compares parameters against in the executor's table.
+			virtual void intern_symbols(symbol_table& symbols) {}
+			//True if hooks can run concurrently on different commands: they don't modify the definition, and only write to the context's outputs.
+			//parallel_commands_executor executes the children of a command on multiple threads only if every definition in its subtree is reentrant.
+			virtual bool reentrant() const noexcept { return false; }
+			//True if hooks execute other definitions through the context's commands_executor, like a replacement executing its expansion.
+			//Which ones depends on the invocation, so such a definition only counts as reentrant if every definition of the executor is.
+			virtual bool executes_other_definitions() const noexcept { return false; }
+
+			//Same hooks for commands of a flat_tree. Definitions meant to be used with both representations override both sets.
+			virtual void validate(const typename flat_tree<char_t>::command_view& command, const execution_context<char_t>& context) const {}
+			virtual void on_begin(const typename flat_tree<char_t>::command_view& command, execution_context<char_t>& context) {}
+			virtual void on_end  (const typename flat_tree<char_t>::command_view& command, execution_context<char_t>& context) {}
+			virtual void on_child(const typename flat_tree<char_t>::command_view& command, const typename flat_tree<char_t>::command_view& child_command, execution_context<char_t>& context) {}
+			virtual void on_child(const typename flat_tree<char_t>::command_view& command, const typename flat_tree<char_t>::range_view  & child_range  , execution_context<char_t>& context) {}
 			};
 		}
 
@@ -39,26 +63,29 @@ namespace barnack::text_parser
 			using string_t       = std::basic_string      <char_t>;
 			using stringstream_t = std::basic_stringstream<char_t>;
 			using input_command_t  = typename tree_parser<char_t>::command;
+			using input_command_view_t = typename flat_tree<char_t>::command_view;
 
 			std::unordered_map<std::string, std::reference_wrapper<command_definition::base<char_t>>> commands_definitions;
+			//Parsers given this table store command names' symbols, which are then dispatched through commands_definitions_by_symbol without hashing strings.
+			symbol_table symbols;
+			std::vector<utils::observer_ptr<command_definition::base<char_t>>> commands_definitions_by_symbol;
 
 			void set_commands(commands_observers_iterable_list<char_t> auto& commands_observers_iterable_list)
 				{
 				commands_definitions.clear();
+				commands_definitions_by_symbol.clear();
 				add_commands(commands_observers_iterable_list);
 				}
 			void set_commands(commands_iterable_list<char_t> auto& commands_observers_iterable_list)
 				{
 				commands_definitions.clear();
+				commands_definitions_by_symbol.clear();
 				add_commands(commands_observers_iterable_list);
 				}
 
 			void add_commands(commands_observers_iterable_list<char_t> auto& commands_observers_iterable_list)
 				{
-				for (auto& command_observer : commands_observers_iterable_list)
-					{
-					commands_definitions.insert({command_observer->name(), std::reference_wrapper<command_definition::base<char>>{*command_observer}});
-					}
+				for (auto& command_observer : commands_observers_iterable_list) { add_command(*command_observer); }
 				}
 			void add_commands(commands_iterable_list<char_t> auto& commands_iterable_list)
 				{
@@ -66,12 +93,34 @@ namespace barnack::text_parser
 				}
 			void add_command(std::derived_from<command_definition::base<char_t>> auto& command)
 				{
-				commands_definitions.insert({command.name(), std::reference_wrapper<command_definition::base<char_t>>{command}});
+				const std::string name{command.name()};
+				const auto inserted{commands_definitions.insert({name, std::reference_wrapper<command_definition::base<char_t>>{command}})};
+				if (!inserted.second) { return; }
+
+				const symbol_table::symbol_t symbol{symbols.intern(name)};
+				if (symbol >= commands_definitions_by_symbol.size()) { commands_definitions_by_symbol.resize(symbol + 1, nullptr); }
+				commands_definitions_by_symbol[symbol] = std::addressof(command);
+
+				command.intern_symbols(symbols);
 				}
 
-			void execute(const input_command_t& input_command);
+			//True if every registered definition is reentrant.
+			bool all_reentrant() const noexcept;
+
+			void execute(const input_command_t     & input_command, execution_context<char_t>& context);
+			void execute(const input_command_view_t& input_command, execution_context<char_t>& context);
+			//Without outputs, for definitions that only have side effects.
+			void execute(const input_command_t     & input_command);
+			void execute(const input_command_view_t& input_command);
+
+			command_definition::base<char_t>& find_command_definition(const typename tokeniser<char_t>::range     & input_command_name, symbol_table::symbol_t input_command_symbol = symbol_table::none);
+			command_definition::base<char_t>& find_command_definition(const typename flat_tree<char_t>::range_view& input_command_name, symbol_table::symbol_t input_command_symbol = symbol_table::none);
+			//Null instead of throwing if there's no such command.
+			utils::observer_ptr<command_definition::base<char_t>> try_find_command_definition(view_t input_command_name, symbol_table::symbol_t input_command_symbol = symbol_table::none);
 
 		private:
+			//The name's position is only needed, and its line only looked up, when the command is missing.
+			command_definition::base<char_t>& find_command_definition(view_t input_command_name, symbol_table::symbol_t input_command_symbol, auto&& position_to_string);
 		};
 	}
 
@@ -0,0 +1,54 @@
+#include "compact_range.h"
+
+#include <algorithm>
+
+#include "simd.h"
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	line_index<char_t>::line_index(view_t string)
+		{
+		assign(string);
+		}
+
+	template <typename char_t>
+	void line_index<char_t>::assign(view_t string)
+		{
+		this->string = string;
+		newlines_positions.clear();
+		simd::for_each_block(string.data(), string.data() + string.size(), [this](const simd::block<char_t>& block, size_t block_begin)
+			{
+			simd::for_each_bit(block.equal(static_cast<char_t>('\n')), [&](size_t index) { newlines_positions.push_back(block_begin + index); });
+			return false;
+			});
+		}
+
+	template <typename char_t>
+	typename line_index<char_t>::tokeniser_t::iterator_with_info line_index<char_t>::at(size_t position) const noexcept
+		{
+		//Newlines strictly before the position. A newline belongs to the line it terminates.
+		const auto newlines_before_end{std::lower_bound(newlines_positions.begin(), newlines_positions.end(), position)};
+		const size_t line{static_cast<size_t>(newlines_before_end - newlines_positions.begin())};
+		const size_t line_begin{line ? (*(newlines_before_end - 1) + 1) : 0};
+
+		const typename tokeniser_t::iterator_with_info ret
+			{
+			.it              {string.data() + position},
+			.position        {position},
+			.line            {line},
+			.position_in_line{position - line_begin}
+			};
+		return ret;
+		}
+
+	template <typename char_t>
+	typename line_index<char_t>::tokeniser_t::iterator_with_info line_index<char_t>::at(const typename tokeniser_t::iterator& it) const noexcept
+		{
+		return at(static_cast<size_t>(it - string.data()));
+		}
+
+	template struct line_index<char16_t>;
+	template struct line_index<char8_t>;
+	template struct line_index<char>;
+	}
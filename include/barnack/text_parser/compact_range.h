@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <concepts>
+#include <stdexcept>
+
+#include "tokeniser.h"
+
+namespace barnack::text_parser
+	{
+	//Range stored as offsets in code units from the beginning of the source string, 8 bytes with the default offset type instead of the 64 of tokeniser::range.
+	//Line information is not stored, it is recovered on demand through a line_index built for the same source.
+	//This is the range representation of flat_tree. tree_parser's tree keeps full tokeniser::range values, which its consumers read line information from directly.
+	template <std::unsigned_integral OFFSET_T = uint32_t>
+	struct compact_range
+		{
+		using offset_t = OFFSET_T;
+
+		offset_t begin{0};
+		offset_t end{0};
+
+		bool   empty() const noexcept { return begin == end; }
+		size_t size () const noexcept { return static_cast<size_t>(end - begin); }
+
+		template <typename char_t>
+		std::basic_string_view<char_t> string(std::basic_string_view<char_t> source) const noexcept
+			{
+			return source.substr(static_cast<size_t>(begin), size());
+			}
+		};
+
+	//Positions of all the newlines of a source string, built once per document with a vectorized scan.
+	//Lines and positions in line of any offset are then found with a binary search, so ranges don't need to carry them around.
+	template <typename CHAR_T>
+	struct line_index
+		{
+		using char_t      = CHAR_T;
+		using view_t      = std::basic_string_view<char_t>;
+		using tokeniser_t = tokeniser<char_t>;
+
+		line_index(view_t string);
+		//Indexes another string, reusing the allocated memory.
+		void assign(view_t string);
+
+		view_t string;
+		std::vector<size_t> newlines_positions;
+
+		typename tokeniser_t::iterator_with_info at(size_t position) const noexcept;
+		typename tokeniser_t::iterator_with_info at(const typename tokeniser_t::iterator& it) const noexcept;
+
+		template <std::unsigned_integral offset_t>
+		typename tokeniser_t::range expand(const compact_range<offset_t>& range) const noexcept
+			{
+			return {at(static_cast<size_t>(range.begin)), at(static_cast<size_t>(range.end))};
+			}
+
+		template <std::unsigned_integral offset_t = uint32_t>
+		compact_range<offset_t> compact(const typename tokeniser_t::range& range) const
+			{
+			return {offset_of<offset_t>(range.begin.it), offset_of<offset_t>(range.end.it)};
+			}
+
+		private:
+			template <std::unsigned_integral offset_t>
+			offset_t offset_of(const typename tokeniser_t::iterator& it) const
+				{
+				const size_t position{static_cast<size_t>(it - string.data())};
+				if (it < string.data() || position > string.size())
+					{
+					throw std::out_of_range{"Range does not belong to the source of this line index."};
+					}
+				if (position > std::numeric_limits<offset_t>::max())
+					{
+					throw std::length_error{"Source too big for the chosen compact_range offset type, position " + std::to_string(position) + " cannot be represented."};
+					}
+				return static_cast<offset_t>(position);
+				}
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "compact_range.cpp"
+#endif
@@ -0,0 +1,107 @@
+#include "content_hash.h"
+
+#include <bit>
+#include <cstring>
+#include <concepts>
+
+namespace barnack::text_parser
+	{
+	namespace
+		{
+		constexpr uint64_t prime_1{0x9E3779B185EBCA87ull};
+		constexpr uint64_t prime_2{0xC2B2AE3D27D4EB4Full};
+		constexpr uint64_t prime_3{0x165667B19E3779F9ull};
+		constexpr uint64_t prime_4{0x85EBCA77C2B2AE63ull};
+		constexpr uint64_t prime_5{0x27D4EB2F165667C5ull};
+
+		//std::byteswap is C++23. Compilers recognise the shifts as a byte swap instruction too.
+		template <std::unsigned_integral T>
+		constexpr T byteswap(T value) noexcept
+			{
+#if defined(__cpp_lib_byteswap)
+			return std::byteswap(value);
+#else
+			T ret{0};
+			for (size_t i{0}; i < sizeof(T); i++) { ret = static_cast<T>((ret << 8) | ((value >> (i * 8)) & 0xFF)); }
+			return ret;
+#endif
+			}
+
+		//Unaligned little endian reads, memcpy compiles to a plain load.
+		uint64_t read_64(const unsigned char* bytes) noexcept
+			{
+			uint64_t ret;
+			std::memcpy(&ret, bytes, sizeof(ret));
+			if constexpr (std::endian::native == std::endian::big) { ret = byteswap(ret); }
+			return ret;
+			}
+		uint64_t read_32(const unsigned char* bytes) noexcept
+			{
+			uint32_t ret;
+			std::memcpy(&ret, bytes, sizeof(ret));
+			if constexpr (std::endian::native == std::endian::big) { ret = byteswap(ret); }
+			return ret;
+			}
+
+		uint64_t round(uint64_t accumulator, uint64_t input) noexcept
+			{
+			accumulator += input * prime_2;
+			accumulator  = std::rotl(accumulator, 31);
+			return accumulator * prime_1;
+			}
+		uint64_t merge_round(uint64_t accumulator, uint64_t lane) noexcept
+			{
+			accumulator ^= round(0, lane);
+			return accumulator * prime_1 + prime_4;
+			}
+		}
+
+	uint64_t content_hash(const void* data, size_t size, uint64_t seed) noexcept
+		{
+		const unsigned char* it {static_cast<const unsigned char*>(data)};
+		const unsigned char* end{it + size};
+		uint64_t ret;
+
+		if (size >= 32)
+			{
+			//Four independent lanes over 32 bytes stripes keep the multipliers busy.
+			uint64_t lanes[4]{seed + prime_1 + prime_2, seed + prime_2, seed, seed - prime_1};
+			for (; end - it >= 32; it += 32)
+				{
+				for (size_t i{0}; i < 4; i++) { lanes[i] = round(lanes[i], read_64(it + i * 8)); }
+				}
+			ret = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+			for (size_t i{0}; i < 4; i++) { ret = merge_round(ret, lanes[i]); }
+			}
+		else
+			{
+			ret = seed + prime_5;
+			}
+
+		ret += static_cast<uint64_t>(size);
+
+		for (; end - it >= 8; it += 8)
+			{
+			ret ^= round(0, read_64(it));
+			ret  = std::rotl(ret, 27) * prime_1 + prime_4;
+			}
+		if (end - it >= 4)
+			{
+			ret ^= read_32(it) * prime_1;
+			ret  = std::rotl(ret, 23) * prime_2 + prime_3;
+			it += 4;
+			}
+		for (; it < end; it++)
+			{
+			ret ^= (*it) * prime_5;
+			ret  = std::rotl(ret, 11) * prime_1;
+			}
+
+		ret ^= ret >> 33;
+		ret *= prime_2;
+		ret ^= ret >> 29;
+		ret *= prime_3;
+		ret ^= ret >> 32;
+		return ret;
+		}
+	}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace barnack::text_parser
+	{
+	//Fast non-cryptographic 64 bits hash of a document's bytes (XXH64), to recognise a source that was already parsed without comparing it whole.
+	//Same value on every platform with the same byte order, so it can name files that outlive the process.
+	uint64_t content_hash(const void* data, size_t size, uint64_t seed = 0) noexcept;
+
+	template <typename char_t>
+	uint64_t content_hash(std::basic_string_view<char_t> string, uint64_t seed = 0) noexcept
+		{
+		return content_hash(string.data(), string.size() * sizeof(char_t), seed);
+		}
+	}
+
+#ifdef IMPLEMENTATION
+#include "content_hash.cpp"
+#endif
@@ -0,0 +1,119 @@
+#include "document_cache.h"
+
+#include <variant>
+
+#include "content_hash.h"
+
+namespace barnack::text_parser
+	{
+	namespace
+		{
+		template <typename tree_parser_t>
+		size_t sequence_bytes(const typename tree_parser_t::sequence& sequence)
+			{
+			size_t ret{sequence.capacity() * sizeof(typename tree_parser_t::sequence_element)};
+			for (const auto& element : sequence)
+				{
+				if (const auto command_ptr{std::get_if<typename tree_parser_t::command>(&element)})
+					{
+					ret += command_ptr->parameters.capacity() * sizeof(typename tree_parser_t::parameter);
+					ret += sequence_bytes<tree_parser_t>(command_ptr->children);
+					}
+				}
+			return ret;
+			}
+		}
+
+	template <typename char_t>
+	document_cache<char_t>::document::document(view_t source, const create_info& create_info) : source{source}
+		{
+		tokeniser_t tokeniser{this->source, create_info.validation};
+		tokeniser.identifiers = create_info.identifiers;
+		parser.symbol_table_ptr = create_info.symbol_table_ptr;
+		parser.parse_all(tokeniser);
+
+		bytes = sizeof(document) + this->source.capacity() * sizeof(char_t) + parser.strings.size() * sizeof(char_t) + sequence_bytes<tree_parser_t>(parser.root.children);
+		}
+
+	template <typename char_t>
+	document_cache<char_t>::document_cache(const create_info& create_info) : settings{create_info} {}
+
+	template <typename char_t>
+	std::shared_ptr<const typename document_cache<char_t>::document> document_cache<char_t>::parse(view_t source)
+		{
+		const uint64_t hash{content_hash(source)};
+			{
+			std::scoped_lock lock{mutex};
+			const auto found{entries_by_hash.find(hash)};
+			if (found != entries_by_hash.end() && found->second->document_ptr->source == source)
+				{
+				entries.splice(entries.begin(), entries, found->second);
+				counters.hits++;
+				return found->second->document_ptr;
+				}
+			counters.misses++;
+			}
+
+		auto ret{std::make_shared<const document>(source, settings)};
+		if (ret->size_bytes() > settings.capacity_bytes) { return ret; }
+
+		std::scoped_lock lock{mutex};
+		const auto found{entries_by_hash.find(hash)};
+		if (found != entries_by_hash.end())
+			{
+			const auto& cached{found->second->document_ptr};
+			if (cached->source == source)
+				{
+				entries.splice(entries.begin(), entries, found->second);
+				return cached;
+				}
+			//Hash collision, the newer document takes the slot.
+			counters.bytes -= cached->size_bytes();
+			counters.documents--;
+			entries.erase(found->second);
+			entries_by_hash.erase(found);
+			}
+
+		evict_to(settings.capacity_bytes - ret->size_bytes());
+		entries.push_front({hash, ret});
+		entries_by_hash.emplace(hash, entries.begin());
+		counters.bytes += ret->size_bytes();
+		counters.documents++;
+		return ret;
+		}
+
+	template <typename char_t>
+	void document_cache<char_t>::evict_to(size_t capacity_bytes)
+		{
+		while (counters.bytes > capacity_bytes)
+			{
+			const entry& last{entries.back()};
+			counters.bytes -= last.document_ptr->size_bytes();
+			counters.documents--;
+			counters.evictions++;
+			entries_by_hash.erase(last.hash);
+			entries.pop_back();
+			}
+		}
+
+	template <typename char_t>
+	typename document_cache<char_t>::statistics document_cache<char_t>::get_statistics() const
+		{
+		std::scoped_lock lock{mutex};
+		return counters;
+		}
+
+	template <typename char_t>
+	void document_cache<char_t>::clear()
+		{
+		std::scoped_lock lock{mutex};
+		entries.clear();
+		entries_by_hash.clear();
+		counters.bytes     = 0;
+		counters.documents = 0;
+		}
+
+	template class document_cache<char16_t>;
+	template class document_cache<char8_t>;
+	template class document_cache<char>;
+	}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include <utils/memory.h>
+
+#include "tokeniser.h"
+#include "tree_parser.h"
+#include "symbol_table.h"
+
+namespace barnack::text_parser
+	{
+	//Parsed documents shared between the requests that bring the same source, so that repeated sources skip tokenising and parsing.
+	//Sources are looked up by content_hash and compared whole on a match. Documents are immutable once parsed and handed out by shared_ptr:
+	//evicting one only drops the cache's reference, the callers still using it keep it alive.
+	//The total size of the cached trees is kept under a byte budget by evicting the least recently used documents. All members are thread safe.
+	template <typename CHAR_T>
+	class document_cache
+		{
+		public:
+			using char_t        = CHAR_T;
+			using view_t        = std::basic_string_view<char_t>;
+			using string_t      = std::basic_string     <char_t>;
+			using tokeniser_t   = tokeniser  <char_t>;
+			using tree_parser_t = tree_parser<char_t>;
+
+			struct create_info
+				{
+				//Upper bound of the bytes of all the cached documents. A document bigger than this is parsed but not cached.
+				size_t capacity_bytes{64 * 1024 * 1024};
+				typename tokeniser_t::validation        validation {tokeniser_t::validation::per_codepoint};
+				typename tokeniser_t::identifier_syntax identifiers{tokeniser_t::identifier_syntax::ascii};
+				//Symbols of the parsed trees, must be the table of the commands_executor they will be executed with.
+				utils::observer_ptr<const symbol_table> symbol_table_ptr{nullptr};
+				};
+
+			//Owns a copy of the source its tree points into. Never moves once created.
+			class document
+				{
+				public:
+					document(view_t source, const create_info& create_info);
+					document(const document& copy) = delete;
+					document& operator=(const document& copy) = delete;
+
+					const string_t source;
+					const typename tree_parser_t::command& root() const noexcept { return parser.root; }
+					//Source, tree and decoded strings, as counted against the cache's capacity.
+					size_t size_bytes() const noexcept { return bytes; }
+
+				private:
+					tree_parser_t parser;
+					size_t bytes{0};
+				};
+
+			struct statistics
+				{
+				size_t hits     {0};
+				size_t misses   {0};
+				size_t evictions{0};
+				size_t documents{0};
+				size_t bytes    {0};
+				};
+
+			document_cache(const create_info& create_info);
+
+			//Parses source unless an identical one is cached. Parse errors are rethrown and nothing is cached.
+			//Parsing happens outside of the lock: threads missing the same source at the same time each parse it, the first to finish is kept.
+			std::shared_ptr<const document> parse(view_t source);
+
+			statistics get_statistics() const;
+			void clear();
+
+		private:
+			const create_info settings;
+
+			struct entry
+				{
+				uint64_t hash;
+				std::shared_ptr<const document> document_ptr;
+				};
+
+			mutable std::mutex mutex;
+			//Most recently used first.
+			std::list<entry> entries;
+			std::unordered_map<uint64_t, typename std::list<entry>::iterator> entries_by_hash;
+			statistics counters;
+
+			void evict_to(size_t capacity_bytes);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "document_cache.cpp"
+#endif
@@ -0,0 +1,195 @@
+#include "executing_parser.h"
+
+#include <utility>
+#include <stdexcept>
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	executing_parser<char_t>::executing_parser(execution_context<char_t>& context) :
+		context{context},
+		commands_executor{context.commands_executor_ptr ? *context.commands_executor_ptr : throw std::logic_error{"The execution context of an executing_parser must have a commands_executor."}}
+		{
+		this->symbol_table_ptr = std::addressof(commands_executor.symbols);
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::parse_and_execute(tokeniser_t& tokeniser)
+		{
+		begin_root();
+		this->parse_all(tokeniser);
+		end_all();
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::parse_and_execute(tokeniser_t& tokeniser, const structural_index<char_t>& structural_index)
+		{
+		begin_root();
+		this->parse_all(tokeniser, structural_index);
+		end_all();
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::begin_root()
+		{
+		frames_count = 0;
+		this->open_bodies_count = 0;
+		buffered_sequences_stack.clear();
+
+		header.name = {};
+		header.name_symbol = symbol_table::none;
+		header.parameters.clear();
+		open_command(true);
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::end_all()
+		{
+		//Like commands_executor does for a tree, bodies still open at the end of the string are executed with what they contain so far.
+		if (!buffered_sequences_stack.empty())
+			{
+			buffered_sequences_stack.clear();
+			commands_executor.execute(buffered, context);
+			}
+		while (frames_count > 0) { close_command(); }
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::open_command(bool has_body)
+		{
+		utils::observer_ptr<command_definition::base<char_t>> definition_ptr{nullptr};
+		if (frames_count == 0)
+			{
+			definition_ptr = std::addressof(commands_executor.find_command_definition(header.name, header.name_symbol));
+			}
+		else
+			{
+			const auto& parent{frames[frames_count - 1]};
+			if (parent.definition_ptr)
+				{
+				parent.definition_ptr->on_child(parent.command, header, context);
+				if (parent.definition_ptr->execute_child_commands())
+					{
+					definition_ptr = std::addressof(commands_executor.find_command_definition(header.name, header.name_symbol));
+					}
+				}
+			}
+
+		if (definition_ptr && definition_ptr->needs_whole_body())
+			{
+			std::swap(buffered, header);
+			buffered.children.clear();
+			if (has_body)
+				{
+				buffered_sequences_stack.push_back(std::addressof(buffered.children));
+				}
+			else
+				{
+				commands_executor.execute(buffered, context);
+				}
+			return;
+			}
+
+		if (definition_ptr)
+			{
+			definition_ptr->validate(header, context);
+			definition_ptr->on_begin(header, context);
+			}
+
+		if (!has_body)
+			{
+			if (definition_ptr) { definition_ptr->on_end(header, context); }
+			return;
+			}
+
+		if (frames_count == frames.size()) { frames.emplace_back(); }
+		auto& frame{frames[frames_count]};
+		std::swap(frame.command, header);
+		frame.definition_ptr = definition_ptr;
+		frames_count++;
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::close_command()
+		{
+		const auto& frame{frames[frames_count - 1]};
+		if (frame.definition_ptr) { frame.definition_ptr->on_end(frame.command, context); }
+		frames_count--;
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::on_raw(const typename tokeniser_t::range& raw_text)
+		{
+		if (!buffered_sequences_stack.empty())
+			{
+			buffered_sequences_stack.back()->emplace_back(raw_text);
+			return;
+			}
+
+		const auto& parent{frames[frames_count - 1]};
+		if (parent.definition_ptr) { parent.definition_ptr->on_child(parent.command, raw_text, context); }
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol)
+		{
+		if (!buffered_sequences_stack.empty())
+			{
+			buffered_last_command_ptr = std::addressof(std::get<command_t>(buffered_sequences_stack.back()->emplace_back(command_t{.name{name}, .name_symbol{name_symbol}, .parameters{}, .children{}})));
+			return;
+			}
+
+		header.name = name;
+		header.name_symbol = name_symbol;
+		header.parameters.clear();
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::on_parameter(const parameter& parameter)
+		{
+		if (!buffered_sequences_stack.empty())
+			{
+			buffered_last_command_ptr->parameters.emplace_back(parameter);
+			return;
+			}
+
+		header.parameters.emplace_back(parameter);
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::on_command_end()
+		{
+		if (!buffered_sequences_stack.empty()) { return; }
+		open_command(false);
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::on_body_begin()
+		{
+		if (!buffered_sequences_stack.empty())
+			{
+			buffered_sequences_stack.push_back(std::addressof(buffered_last_command_ptr->children));
+			return;
+			}
+		open_command(true);
+		}
+
+	template <typename char_t>
+	void executing_parser<char_t>::on_body_end()
+		{
+		if (!buffered_sequences_stack.empty())
+			{
+			buffered_sequences_stack.pop_back();
+			if (buffered_sequences_stack.empty())
+				{
+				commands_executor.execute(buffered, context);
+				}
+			return;
+			}
+		close_command();
+		}
+
+	template class executing_parser<char16_t>;
+	template class executing_parser<char8_t>;
+	template class executing_parser<char>;
+	}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include <utils/memory.h>
+
+#include "parser_base.h"
+#include "tree_parser.h"
+#include "commands_executor.h"
+#include "execution_context.h"
+
+namespace barnack::text_parser
+	{
+	//Executes commands as they are parsed, instead of building the whole tree and then executing it with commands_executor.
+	//Only the stack of currently open commands is kept. Hooks receive commands with their name and parameters but without children,
+	//except for definitions that return true from needs_whole_body, whose subtree is buffered and executed once it's complete.
+	template <typename CHAR_T>
+	class executing_parser : public parser_base<CHAR_T>
+		{
+		public:
+			using char_t      = typename parser_base<CHAR_T>::char_t;
+			using view_t      = typename parser_base<CHAR_T>::view_t;
+			using tokeniser_t = typename parser_base<CHAR_T>::tokeniser_t;
+			using command_t   = typename tree_parser<char_t>::command;
+			using symbol_t    = typename parser_base<CHAR_T>::symbol_t;
+			using parameter   = typename parser_base<CHAR_T>::parameter;
+
+			//The context's commands_executor resolves the commands, hooks receive the context.
+			executing_parser(execution_context<char_t>& context);
+
+			//Executes the root command, whose body is the whole string.
+			void parse_and_execute(tokeniser_t& tokeniser);
+			void parse_and_execute(tokeniser_t& tokeniser, const structural_index<char_t>& structural_index);
+
+		protected:
+			virtual void on_raw          (const typename tokeniser_t::range& raw_text ) override;
+			virtual void on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol) override;
+			virtual void on_parameter    (const parameter& parameter) override;
+			virtual void on_command_end  () override;
+			virtual void on_body_begin   () override;
+			virtual void on_body_end     () override;
+
+		private:
+			execution_context<char_t>& context;
+			text_parser::commands_executor<char_t>& commands_executor;
+
+			struct frame
+				{
+				command_t command;
+				//nullptr for commands that are not executed because their parent doesn't execute child commands.
+				utils::observer_ptr<command_definition::base<char_t>> definition_ptr{nullptr};
+				};
+			//Frames are reused across commands to reuse their parameters vector's capacity, frames_count is the actual stack size.
+			std::vector<frame> frames;
+			size_t frames_count{0};
+			command_t header;
+
+			command_t buffered;
+			std::vector<utils::observer_ptr<typename tree_parser<char_t>::sequence>> buffered_sequences_stack;
+			utils::observer_ptr<command_t> buffered_last_command_ptr{nullptr};
+
+			void begin_root();
+			void end_all();
+			void open_command(bool has_body);
+			void close_command();
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "executing_parser.cpp"
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <utils/memory.h>
+
+namespace barnack::text_parser
+	{
+	template <typename CHAR_T>
+	class commands_executor;
+
+	//State of one execution, passed to every hook, so that definitions themselves stay immutable and one set of definitions can execute many documents at once.
+	//Outputs are registered by type: a definition writing text looks for an output_sink<output_char_t>, the exact type it was registered as.
+	//Definitions skip their output when the context has none of the type they write to.
+	template <typename CHAR_T>
+	class execution_context
+		{
+		public:
+			using char_t = CHAR_T;
+
+			execution_context() = default;
+			execution_context(commands_executor<char_t>& commands_executor) noexcept : commands_executor_ptr{std::addressof(commands_executor)} {}
+
+			//Executor that definitions expanding to new commands execute them with.
+			utils::observer_ptr<commands_executor<char_t>> commands_executor_ptr{nullptr};
+
+			template <typename T>
+			utils::observer_ptr<T> output() const noexcept
+				{
+				for (const auto& entry : outputs)
+					{
+					if (entry.type == type_key<T>()) { return static_cast<T*>(entry.pointer); }
+					}
+				return nullptr;
+				}
+
+			//Replaces the output of the same type if there's one, nullptr removes it.
+			template <typename T>
+			void set_output(utils::observer_ptr<T> output)
+				{
+				for (auto it{outputs.begin()}; it != outputs.end(); it++)
+					{
+					if (it->type != type_key<T>()) { continue; }
+					if (output) { it->pointer = output; }
+					else { outputs.erase(it); }
+					return;
+					}
+				if (output) { outputs.push_back({type_key<T>(), output}); }
+				}
+
+		private:
+			struct entry
+				{
+				const void* type;
+				void* pointer;
+				};
+			//A handful of outputs at most, a linear search beats hashing.
+			std::vector<entry> outputs;
+
+			//Writable so that each type's variable keeps its own address, identical constants may be merged by the linker.
+			template <typename T>
+			static const void* type_key() noexcept
+				{
+				static char key;
+				return std::addressof(key);
+				}
+		};
+	}
@@ -0,0 +1,99 @@
+#include "expansion_cache.h"
+
+#include <vector>
+
+namespace barnack::text_parser
+	{
+	namespace
+		{
+		//Appends to path the indices leading to the first splice found in sequence, false if there is none.
+		template <typename char_t>
+		bool find_splice_path(const typename tree_parser<char_t>::sequence& sequence, std::vector<size_t>& path)
+			{
+			for (size_t i{0}; i < sequence.size(); i++)
+				{
+				path.push_back(i);
+				if (std::holds_alternative<typename tree_parser<char_t>::splice>(sequence[i])) { return true; }
+				if (const auto command_ptr{std::get_if<typename tree_parser<char_t>::command>(&sequence[i])})
+					{
+					if (find_splice_path<char_t>(command_ptr->children, path)) { return true; }
+					}
+				path.pop_back();
+				}
+			return false;
+			}
+		}
+
+	template <typename char_t>
+	void expansion_cache<char_t>::expansion::find_body_splice()
+		{
+		body_splice_path.clear();
+		find_splice_path<char_t>(root.children, body_splice_path);
+		}
+
+	template <typename char_t>
+	typename expansion_cache<char_t>::command_t expansion_cache<char_t>::expansion::instantiate(const sequence_t& body) const
+		{
+		command_t ret{root};
+		if (body_splice_path.empty()) { return ret; }
+
+		utils::observer_ptr<sequence_t> sequence_ptr{std::addressof(ret.children)};
+		for (size_t i{0}; i + 1 < body_splice_path.size(); i++)
+			{
+			sequence_ptr = std::addressof(std::get<command_t>((*sequence_ptr)[body_splice_path[i]]).children);
+			}
+		std::get<splice_t>((*sequence_ptr)[body_splice_path.back()]).sequence_ptr = std::addressof(body);
+		return ret;
+		}
+
+	template <typename char_t>
+	std::shared_ptr<const typename expansion_cache<char_t>::expansion> expansion_cache<char_t>::find(const string_t& key, const symbol_table& symbols)
+		{
+		const auto it{index.find(view_t{key})};
+		if (it == index.end() || it->second->second->symbols_ptr != std::addressof(symbols))
+			{
+			misses++;
+			return nullptr;
+			}
+
+		hits++;
+		entries.splice(entries.begin(), entries, it->second);
+		return it->second->second;
+		}
+
+	template <typename char_t>
+	void expansion_cache<char_t>::insert(string_t key, std::shared_ptr<const expansion> expansion_ptr)
+		{
+		if (capacity == 0) { return; }
+
+		if (const auto it{index.find(view_t{key})}; it != index.end())
+			{
+			it->second->second = std::move(expansion_ptr);
+			entries.splice(entries.begin(), entries, it->second);
+			return;
+			}
+
+		entries.emplace_front(std::move(key), std::move(expansion_ptr));
+		index.emplace(view_t{entries.front().first}, entries.begin());
+
+		while (entries.size() > capacity)
+			{
+			index.erase(view_t{entries.back().first});
+			entries.pop_back();
+			}
+		}
+
+	template <typename char_t>
+	void expansion_cache<char_t>::clear() noexcept
+		{
+		index.clear();
+		entries.clear();
+		}
+
+	template <typename char_t>
+	size_t expansion_cache<char_t>::size() const noexcept { return entries.size(); }
+
+	template class expansion_cache<char16_t>;
+	template class expansion_cache<char8_t>;
+	template class expansion_cache<char>;
+	}
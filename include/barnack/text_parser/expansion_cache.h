@@ -0,0 +1,84 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <utils/memory.h>
+
+#include "tree_parser.h"
+#include "string_arena.h"
+#include "symbol_table.h"
+
+namespace barnack::text_parser
+	{
+	//Least recently used bounded cache of parsed replacements, keyed by the invocation's parameters and whether it has a body.
+	//Expansions own the strings their trees refer to and are never modified once cached: each invocation executes its own instance, whose body splice points to its body.
+	template <typename CHAR_T>
+	class expansion_cache
+		{
+		public:
+			using char_t     = CHAR_T;
+			using view_t     = std::basic_string_view<char_t>;
+			using string_t   = std::basic_string     <char_t>;
+			using command_t  = typename tree_parser<char_t>::command;
+			using splice_t   = typename tree_parser<char_t>::splice;
+			using sequence_t = typename tree_parser<char_t>::sequence;
+
+			struct expansion
+				{
+				string_t generated_string_before_body;
+				string_t generated_string_after_body;
+				string_arena<char_t> strings;
+				//Table the tree's symbols were looked up in, the one of the executor that expanded it.
+				utils::observer_ptr<const symbol_table> symbols_ptr{nullptr};
+				//The body splice is left unassigned.
+				command_t root;
+				//Indices of the elements leading from root's children to the body splice, empty if the expansion was made for an invocation without body.
+				std::vector<size_t> body_splice_path;
+
+				//Finds the body splice once the tree is complete.
+				void find_body_splice();
+				//Copy of the tree with the body splice pointing to body. It refers to the expansion's strings, which must outlive it.
+				command_t instantiate(const sequence_t& body) const;
+				};
+
+			//Maximum amount of expansions kept, 0 disables the cache.
+			size_t capacity{0};
+			size_t hits  {0};
+			size_t misses{0};
+
+			static string_t key(const auto& command, bool has_body)
+				{
+				//Each parameter is prefixed by its size, so that different parameters can't concatenate to the same key.
+				string_t ret{static_cast<char_t>(has_body ? '1' : '0')};
+				for (size_t i{0}; i < command.parameters.size(); i++)
+					{
+					const view_t string{command.parameters[i].string()};
+					for (const char digit : std::to_string(string.size())) { ret += static_cast<char_t>(digit); }
+					ret += static_cast<char_t>(':');
+					ret += string;
+					}
+				return ret;
+				}
+
+			//Null on a miss. An expansion parsed with another table is a miss too, a definition can be registered with several executors.
+			std::shared_ptr<const expansion> find(const string_t& key, const symbol_table& symbols);
+			void insert(string_t key, std::shared_ptr<const expansion> expansion_ptr);
+			void clear() noexcept;
+			size_t size() const noexcept;
+
+		private:
+			using entries_t = std::list<std::pair<string_t, std::shared_ptr<const expansion>>>;
+			//Most recently used first.
+			entries_t entries;
+			//Keys are views of the entries' keys, list nodes don't move.
+			std::unordered_map<view_t, typename entries_t::iterator> index;
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "expansion_cache.cpp"
+#endif
@@ -0,0 +1,177 @@
+#include "flat_tree.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	flat_tree<char_t>::flat_tree(view_t source) : source{source}, lines{source}
+		{
+		clear();
+		}
+
+	template <typename char_t>
+	void flat_tree<char_t>::assign(view_t source)
+		{
+		this->source = source;
+		lines.assign(source);
+		clear();
+		}
+
+	template <typename char_t>
+	void flat_tree<char_t>::reserve(size_t nodes_count, size_t parameters_count)
+		{
+		kinds            .reserve(nodes_count);
+		ranges           .reserve(nodes_count);
+		first_children   .reserve(nodes_count);
+		next_siblings    .reserve(nodes_count);
+		parameters_firsts.reserve(nodes_count);
+		parameters_counts.reserve(nodes_count);
+		symbols          .reserve(nodes_count);
+		parameters       .reserve(parameters_count);
+		parameters_symbols.reserve(parameters_count);
+		parameters_kinds .reserve(parameters_count);
+		parameters_values.reserve(parameters_count);
+		}
+
+	template <typename char_t>
+	void flat_tree<char_t>::clear()
+		{
+		kinds            .clear();
+		ranges           .clear();
+		first_children   .clear();
+		next_siblings    .clear();
+		parameters_firsts.clear();
+		parameters_counts.clear();
+		symbols          .clear();
+		parameters       .clear();
+		parameters_symbols.clear();
+		parameters_kinds .clear();
+		parameters_values.clear();
+		add_node(node_kind::command, {});
+		}
+
+	template <typename char_t>
+	typename flat_tree<char_t>::index_t flat_tree<char_t>::add_node(node_kind kind, const offsets_t& range, symbol_t symbol)
+		{
+		if (size() >= none)
+			{
+			throw std::length_error{"Too many nodes for a flat_tree."};
+			}
+		const index_t index{static_cast<index_t>(size())};
+		kinds            .push_back(kind);
+		ranges           .push_back(range);
+		first_children   .push_back(none);
+		next_siblings    .push_back(none);
+		parameters_firsts.push_back(static_cast<index_t>(parameters.size()));
+		parameters_counts.push_back(0);
+		symbols          .push_back(symbol);
+		return index;
+		}
+
+	template <typename char_t>
+	typename tree_parser<char_t>::command flat_tree<char_t>::to_command(const command_view& command, bool include_children) const
+		{
+		typename tree_parser<char_t>::command ret{.name{command.name.expand()}, .name_symbol{command.name_symbol}, .parameters{}, .children{}};
+
+		ret.parameters.reserve(command.parameters.size());
+		for (size_t i{0}; i < command.parameters.size(); i++)
+			{
+			ret.parameters.push_back(static_cast<parameter>(command.parameters[i]));
+			}
+
+		if (include_children)
+			{
+			ret.children = to_sequence(command.children);
+			}
+		return ret;
+		}
+
+	template <typename char_t>
+	typename tree_parser<char_t>::sequence flat_tree<char_t>::to_sequence(const children_view& children) const
+		{
+		typename tree_parser<char_t>::sequence ret;
+		for (const auto& child : children)
+			{
+			if (child.is_command()) { ret.emplace_back(to_command(child.command())); }
+			else                    { ret.emplace_back(child.range().expand()); }
+			}
+		return ret;
+		}
+
+
+	template <typename char_t>
+	flat_tree_parser<char_t>::flat_tree_parser(view_t source) : tree{source}
+		{
+		open_bodies.push_back({.command{0}, .last_child{flat_tree<char_t>::none}});
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::reset(view_t source)
+		{
+		tree.assign(source);
+		this->strings.clear();
+		open_bodies.clear();
+		open_bodies.push_back({.command{0}, .last_child{flat_tree<char_t>::none}});
+		last_command = 0;
+		this->open_bodies_count = 0;
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::add_child(typename flat_tree<char_t>::node_kind kind, const typename tokeniser_t::range& range, symbol_t symbol)
+		{
+		const index_t index{tree.add_node(kind, tree.lines.compact(range), symbol)};
+
+		auto& open_body{open_bodies.back()};
+		if (open_body.last_child == flat_tree<char_t>::none) { tree.first_children[open_body.command   ] = index; }
+		else                                                 { tree.next_siblings [open_body.last_child] = index; }
+		open_body.last_child = index;
+
+		if (kind == flat_tree<char_t>::node_kind::command) { last_command = index; }
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::on_raw(const typename tokeniser_t::range& raw_text)
+		{
+		add_child(flat_tree<char_t>::node_kind::raw, raw_text, symbol_table::none);
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol)
+		{
+		add_child(flat_tree<char_t>::node_kind::command, name, name_symbol);
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::on_parameter(const parameter& parameter)
+		{
+		//Parameters immediately follow their command's begin, so they're always appended to the last command's contiguous block.
+		tree.parameters.push_back(tree.lines.compact(parameter));
+		tree.parameters_symbols.push_back(parameter.symbol);
+		tree.parameters_kinds  .push_back(parameter.kind);
+		tree.parameters_values .push_back(parameter.value);
+		tree.parameters_counts[last_command]++;
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::on_body_begin()
+		{
+		open_bodies.push_back({.command{last_command}, .last_child{flat_tree<char_t>::none}});
+		}
+
+	template <typename char_t>
+	void flat_tree_parser<char_t>::on_body_end()
+		{
+		assert(open_bodies.size() > 1);
+		open_bodies.pop_back();
+		}
+
+	template class flat_tree<char16_t>;
+	template class flat_tree<char8_t>;
+	template class flat_tree<char>;
+
+	template class flat_tree_parser<char16_t>;
+	template class flat_tree_parser<char8_t>;
+	template class flat_tree_parser<char>;
+	}
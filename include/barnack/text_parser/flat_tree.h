@@ -0,0 +1,249 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <iterator>
+
+#include <utils/string.h>
+#include <utils/memory.h>
+
+#include "tokeniser.h"
+#include "parser_base.h"
+#include "tree_parser.h"
+#include "compact_range.h"
+
+namespace barnack::text_parser
+	{
+	//Same content as a tree_parser tree, laid out as a structure of arrays in a handful of per-document vectors instead of one vector per command and per children list.
+	//Nodes refer to each other by index and ranges are stored as offsets into the source, so growing the arrays never moves subtrees around and the whole tree is freed at once.
+	template <typename CHAR_T>
+	class flat_tree
+		{
+		public:
+			using char_t      = CHAR_T;
+			using view_t      = std::basic_string_view<char_t>;
+			using tokeniser_t = tokeniser<char_t>;
+			using index_t     = uint32_t;
+			using offsets_t   = compact_range<uint32_t>;
+			using symbol_t    = symbol_table::symbol_t;
+			using token_kind  = typename tokeniser_t::token_kind;
+			using value_t     = typename tokeniser_t::value_t;
+			using parameter   = typename parser_base<char_t>::parameter;
+
+			static constexpr index_t none{std::numeric_limits<index_t>::max()};
+
+			enum class node_kind : uint8_t { command, raw };
+
+			flat_tree(view_t source);
+			//Empties the tree for another source, keeping the allocated memory.
+			void assign(view_t source);
+
+			view_t source;
+			line_index<char_t> lines;
+
+			//One element per node, node 0 is the root command.
+			std::vector<node_kind> kinds;
+			std::vector<offsets_t> ranges; //Name for commands, text for raw nodes.
+			std::vector<index_t  > first_children;
+			std::vector<index_t  > next_siblings;
+			std::vector<index_t  > parameters_firsts;
+			std::vector<index_t  > parameters_counts;
+			std::vector<symbol_t > symbols; //Command names' symbols, none for raw nodes.
+
+			//Parameters of all the commands. Parameters of the same command are contiguous.
+			std::vector<offsets_t > parameters;
+			std::vector<symbol_t  > parameters_symbols;
+			std::vector<token_kind> parameters_kinds;
+			std::vector<value_t   > parameters_values;
+
+			size_t size() const noexcept { return kinds.size(); }
+			void reserve(size_t nodes_count, size_t parameters_count);
+			void clear();
+
+			index_t add_node(node_kind kind, const offsets_t& range, symbol_t symbol = symbol_table::none);
+
+			class command_view;
+
+			//Position whose line information is only looked up, with a binary search in the line index, when asked for.
+			struct position_view
+				{
+				typename tokeniser_t::iterator it{nullptr};
+				utils::observer_ptr<const line_index<char_t>> lines_ptr{nullptr};
+
+				typename tokeniser_t::iterator_with_info expand() const noexcept { return lines_ptr->at(it); }
+				operator typename tokeniser_t::iterator_with_info() const noexcept { return expand(); }
+				std::string to_string() const noexcept { return expand().to_string(); }
+				};
+
+			//Same interface as tokeniser::range for reading, string and iterators cost nothing and line information is computed on demand.
+			struct range_view
+				{
+				range_view() noexcept = default;
+				range_view(const flat_tree& tree, const offsets_t& offsets) noexcept :
+					begin{tree.source.data() + offsets.begin, std::addressof(tree.lines)},
+					end  {tree.source.data() + offsets.end  , std::addressof(tree.lines)}
+					{}
+
+				position_view begin;
+				position_view end;
+
+				view_t string() const noexcept { return view_t{begin.it, end.it}; }
+				bool   empty () const noexcept { return begin.it == end.it; }
+
+				typename tokeniser_t::range expand() const noexcept { return {begin.expand(), end.expand()}; }
+				operator typename tokeniser_t::range() const noexcept { return expand(); }
+				};
+
+			struct parameter_view : range_view
+				{
+				token_kind kind{token_kind::none};
+				value_t value{};
+				symbol_t symbol{symbol_table::none};
+
+				double number() const noexcept { return typename tokeniser_t::token{{}, kind, value}.number(); }
+
+				explicit operator parameter() const noexcept { return {{this->expand(), kind, value}, symbol}; }
+				};
+
+			class node_view
+				{
+				public:
+					node_view(const flat_tree& tree, index_t index) noexcept : tree_ptr{std::addressof(tree)}, index{index} {}
+
+					bool is_command() const noexcept { return tree_ptr->kinds[index] == node_kind::command; }
+					command_view command() const noexcept { return {*tree_ptr, index}; }
+
+					view_t string() const noexcept { return tree_ptr->ranges[index].string(tree_ptr->source); }
+					range_view range() const noexcept { return {*tree_ptr, tree_ptr->ranges[index]}; }
+
+					utils::observer_ptr<const flat_tree> tree_ptr;
+					index_t index;
+				};
+
+			class children_view
+				{
+				public:
+					class iterator
+						{
+						public:
+							using iterator_category = std::forward_iterator_tag;
+							using value_type        = node_view;
+							using difference_type   = std::ptrdiff_t;
+
+							iterator() noexcept = default;
+							iterator(const flat_tree& tree, index_t index) noexcept : tree_ptr{std::addressof(tree)}, index{index} {}
+
+							node_view operator*() const noexcept { return {*tree_ptr, index}; }
+							iterator& operator++()    noexcept { index = tree_ptr->next_siblings[index]; return *this; }
+							iterator  operator++(int) noexcept { iterator ret{*this}; ++(*this); return ret; }
+							bool operator==(const iterator& other) const noexcept { return index == other.index; }
+
+						private:
+							utils::observer_ptr<const flat_tree> tree_ptr{nullptr};
+							index_t index{none};
+						};
+
+					children_view(const flat_tree& tree, index_t first_child) noexcept : tree_ptr{std::addressof(tree)}, first_child{first_child} {}
+
+					iterator begin() const noexcept { return {*tree_ptr, first_child}; }
+					iterator end  () const noexcept { return {*tree_ptr, none       }; }
+					bool     empty() const noexcept { return first_child == none; }
+
+				private:
+					utils::observer_ptr<const flat_tree> tree_ptr;
+					index_t first_child;
+				};
+
+			class parameters_view
+				{
+				public:
+					parameters_view(const flat_tree& tree, index_t first, index_t count) noexcept : tree_ptr{std::addressof(tree)}, first{first}, count{count} {}
+
+					size_t size () const noexcept { return count; }
+					bool   empty() const noexcept { return count == 0; }
+
+					parameter_view operator[](size_t index) const noexcept
+						{
+						const size_t i{first + index};
+						return {{*tree_ptr, tree_ptr->parameters[i]}, tree_ptr->parameters_kinds[i], tree_ptr->parameters_values[i], tree_ptr->parameters_symbols[i]};
+						}
+					view_t string(size_t index) const noexcept { return tree_ptr->parameters[first + index].string(tree_ptr->source); }
+
+				private:
+					utils::observer_ptr<const flat_tree> tree_ptr;
+					index_t first;
+					index_t count;
+				};
+
+			//Exposes name, parameters and children like tree_parser::command does, so the same code can consume either.
+			class command_view
+				{
+				public:
+					command_view(const flat_tree& tree, index_t index) noexcept :
+						name       {tree, tree.ranges[index]},
+						name_symbol{tree.symbols[index]},
+						parameters {tree, tree.parameters_firsts[index], tree.parameters_counts[index]},
+						children   {tree, tree.first_children[index]},
+						tree_ptr   {std::addressof(tree)},
+						index      {index}
+						{}
+
+					range_view name;
+					symbol_t name_symbol;
+					parameters_view parameters;
+					children_view   children;
+
+					utils::observer_ptr<const flat_tree> tree_ptr;
+					index_t index;
+				};
+
+			command_view root() const noexcept { return {*this, 0}; }
+
+			//Deep copies into the tree_parser representation, for code that needs to own or rearrange nodes.
+			typename tree_parser<char_t>::command  to_command (const command_view & command, bool include_children = true) const;
+			typename tree_parser<char_t>::sequence to_sequence(const children_view& children) const;
+		};
+
+	template <typename CHAR_T>
+	class flat_tree_parser : public parser_base<CHAR_T>
+		{
+		public:
+			using char_t      = typename parser_base<CHAR_T>::char_t;
+			using view_t      = typename parser_base<CHAR_T>::view_t;
+			using tokeniser_t = typename parser_base<CHAR_T>::tokeniser_t;
+			using index_t     = typename flat_tree<char_t>::index_t;
+			using symbol_t    = typename parser_base<CHAR_T>::symbol_t;
+			using parameter   = typename parser_base<CHAR_T>::parameter;
+
+			//Every tokeniser later passed to parse_all must refer to this same source.
+			flat_tree_parser(view_t source);
+			//Starts over with another source, reusing the tree's memory. Lets one parser parse many documents without allocating for each.
+			void reset(view_t source);
+
+			flat_tree<char_t> tree;
+
+		protected:
+			virtual void on_raw          (const typename tokeniser_t::range& raw_text ) override;
+			virtual void on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol) override;
+			virtual void on_parameter    (const parameter& parameter) override;
+			virtual void on_body_begin   () override;
+			virtual void on_body_end     () override;
+
+		private:
+			struct open_body_t
+				{
+				index_t command;
+				index_t last_child;
+				};
+			std::vector<open_body_t> open_bodies;
+			index_t last_command{0};
+
+			void add_child(typename flat_tree<char_t>::node_kind kind, const typename tokeniser_t::range& range, symbol_t symbol);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "flat_tree.cpp"
+#endif
@@ -0,0 +1,177 @@
+#include "mapped_file.h"
+
+#include <utility>
+#include <algorithm>
+#include <system_error>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace barnack::text_parser
+	{
+	mapped_file::mapped_file(const std::filesystem::path& path) : mapped_file{path, create_info{}} {}
+
+	mapped_file::mapped_file(const std::filesystem::path& path, const create_info& create_info)
+		{
+		#ifdef _WIN32
+			file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (file_handle == INVALID_HANDLE_VALUE)
+				{
+				file_handle = nullptr;
+				throw std::system_error{static_cast<int>(GetLastError()), std::system_category(), "Error opening \"" + path.string() + "\""};
+				}
+
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file_handle, &file_size))
+				{
+				const auto error{GetLastError()};
+				release();
+				throw std::system_error{static_cast<int>(error), std::system_category(), "Error reading the size of \"" + path.string() + "\""};
+				}
+			size = static_cast<size_t>(file_size.QuadPart);
+			if (size == 0) { return; }
+
+			//Large pages on Windows require privileges and don't apply to file views, the hint is ignored.
+			mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping_handle)
+				{
+				const auto error{GetLastError()};
+				release();
+				throw std::system_error{static_cast<int>(error), std::system_category(), "Error mapping \"" + path.string() + "\""};
+				}
+			data = static_cast<const std::byte*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+			if (!data)
+				{
+				const auto error{GetLastError()};
+				release();
+				throw std::system_error{static_cast<int>(error), std::system_category(), "Error mapping \"" + path.string() + "\""};
+				}
+		#else
+			const int file_descriptor{::open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+			if (file_descriptor < 0)
+				{
+				throw std::system_error{errno, std::generic_category(), "Error opening \"" + path.string() + "\""};
+				}
+
+			struct stat file_stat;
+			if (::fstat(file_descriptor, &file_stat) != 0)
+				{
+				const int error{errno};
+				::close(file_descriptor);
+				throw std::system_error{error, std::generic_category(), "Error reading the size of \"" + path.string() + "\""};
+				}
+			size = static_cast<size_t>(file_stat.st_size);
+			if (size == 0)
+				{
+				::close(file_descriptor);
+				return;
+				}
+
+			void* mapping{::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0)};
+			//The mapping keeps its own reference to the file.
+			::close(file_descriptor);
+			if (mapping == MAP_FAILED)
+				{
+				size = 0;
+				throw std::system_error{errno, std::generic_category(), "Error mapping \"" + path.string() + "\""};
+				}
+			data = static_cast<const std::byte*>(mapping);
+
+			//Advice is only a hint, failures are not errors.
+			::madvise(mapping, size, MADV_SEQUENTIAL);
+			#ifdef MADV_HUGEPAGE
+				if (create_info.huge_pages) { ::madvise(mapping, size, MADV_HUGEPAGE); }
+			#endif
+		#endif
+		}
+
+	mapped_file::mapped_file(mapped_file&& move) noexcept :
+		data{std::exchange(move.data, nullptr)},
+		size{std::exchange(move.size, 0)}
+		#ifdef _WIN32
+			, file_handle   {std::exchange(move.file_handle   , nullptr)}
+			, mapping_handle{std::exchange(move.mapping_handle, nullptr)}
+		#endif
+		{}
+
+	mapped_file& mapped_file::operator=(mapped_file&& move) noexcept
+		{
+		if (this != std::addressof(move))
+			{
+			release();
+			data = std::exchange(move.data, nullptr);
+			size = std::exchange(move.size, 0);
+			#ifdef _WIN32
+				file_handle    = std::exchange(move.file_handle   , nullptr);
+				mapping_handle = std::exchange(move.mapping_handle, nullptr);
+			#endif
+			}
+		return *this;
+		}
+
+	mapped_file::~mapped_file() { release(); }
+
+	void mapped_file::release() noexcept
+		{
+		#ifdef _WIN32
+			if (data          ) { UnmapViewOfFile(data); }
+			if (mapping_handle) { CloseHandle(mapping_handle); }
+			if (file_handle   ) { CloseHandle(file_handle); }
+			mapping_handle = nullptr;
+			file_handle    = nullptr;
+		#else
+			if (data) { ::munmap(const_cast<std::byte*>(data), size); }
+		#endif
+		data = nullptr;
+		size = 0;
+		}
+
+	std::span<const std::byte> mapped_file::bytes() const noexcept { return {data, size}; }
+
+	mapped_file::encoding mapped_file::detect_encoding() const noexcept
+		{
+		const auto starts_with{[this](std::initializer_list<unsigned char> bom)
+			{
+			if (size < bom.size()) { return false; }
+			return std::equal(bom.begin(), bom.end(), data, [](unsigned char a, std::byte b) { return a == static_cast<unsigned char>(b); });
+			}};
+
+		if (starts_with({0xEF, 0xBB, 0xBF})) { return encoding::utf8   ; }
+		if (starts_with({0xFF, 0xFE      })) { return encoding::utf16le; }
+		if (starts_with({0xFE, 0xFF      })) { return encoding::utf16be; }
+		return encoding::utf8_without_bom;
+		}
+
+	size_t mapped_file::bom_size() const noexcept
+		{
+		switch (detect_encoding())
+			{
+			case encoding::utf8   : return 3;
+			case encoding::utf16le: return 2;
+			case encoding::utf16be: return 2;
+			default:                return 0;
+			}
+		}
+
+
+	template <typename char_t>
+	mapped_document<char_t>::mapped_document(std::shared_ptr<const mapped_file> file) :
+		file{std::move(file)},
+		//Files come from outside, validating them once lets the parser decode without checks.
+		tokeniser{this->file->template view<char_t>(), tokeniser_t::validation::upfront}
+		{
+		parser.parse_all(tokeniser);
+		}
+
+	template class mapped_document<char16_t>;
+	template class mapped_document<char8_t>;
+	template class mapped_document<char>;
+	}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <span>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <concepts>
+#include <stdexcept>
+#include <filesystem>
+
+#include "tokeniser.h"
+#include "tree_parser.h"
+
+namespace barnack::text_parser
+	{
+	//Read-only memory mapping of a whole file, so documents can be tokenised in place without first copying them into a string.
+	class mapped_file
+		{
+		public:
+			enum class encoding { utf8_without_bom, utf8, utf16le, utf16be };
+
+			struct create_info
+				{
+				//Hints the kernel towards huge pages where supported, ignored otherwise.
+				bool huge_pages{false};
+				};
+
+			mapped_file(const std::filesystem::path& path);
+			mapped_file(const std::filesystem::path& path, const create_info& create_info);
+			mapped_file(const mapped_file& copy) = delete;
+			mapped_file(mapped_file&& move) noexcept;
+			mapped_file& operator=(const mapped_file& copy) = delete;
+			mapped_file& operator=(mapped_file&& move) noexcept;
+			~mapped_file();
+
+			std::span<const std::byte> bytes() const noexcept;
+
+			encoding detect_encoding() const noexcept;
+			size_t   bom_size       () const noexcept;
+
+			//Content after the byte order mark. Throws if char_t doesn't match the detected encoding.
+			template <typename char_t>
+			std::basic_string_view<char_t> view() const
+				{
+				const encoding encoding{detect_encoding()};
+				const bool matches
+					{
+					(std::same_as<char_t, char    > && encoding == encoding::utf8_without_bom) ||
+					(std::same_as<char_t, char8_t > && encoding == encoding::utf8            ) ||
+					(std::same_as<char_t, char16_t> && encoding == encoding::utf16le         )
+					};
+				if (!matches)
+					{
+					throw std::runtime_error{"Mapped file encoding does not match the requested character type."};
+					}
+
+				const auto content{bytes().subspan(bom_size())};
+				return {reinterpret_cast<const char_t*>(content.data()), content.size() / sizeof(char_t)};
+				}
+
+			//Calls callback with the file content as a view of the character type matching its byte order mark: char8_t for UTF-8 with BOM, char16_t for UTF-16, char otherwise.
+			decltype(auto) visit(auto&& callback) const
+				{
+				switch (detect_encoding())
+					{
+					case encoding::utf8   : return callback(view<char8_t >());
+					case encoding::utf16le: return callback(view<char16_t>());
+					case encoding::utf16be: throw std::runtime_error{"Big endian UTF-16 files are not supported."};
+					default:                return callback(view<char    >());
+					}
+				}
+
+		private:
+			const std::byte* data{nullptr};
+			size_t size{0};
+			#ifdef _WIN32
+				void* file_handle{nullptr};
+				void* mapping_handle{nullptr};
+			#endif
+
+			void release() noexcept;
+		};
+
+	//A document parsed straight from a mapped file. The ranges of the tree point into the mapping, which the document keeps alive.
+	template <typename CHAR_T>
+	class mapped_document
+		{
+		public:
+			using char_t        = CHAR_T;
+			using tokeniser_t   = text_parser::tokeniser  <char_t>;
+			using tree_parser_t = text_parser::tree_parser<char_t>;
+
+			mapped_document(std::shared_ptr<const mapped_file> file);
+			mapped_document(const mapped_document& copy) = delete;
+			mapped_document& operator=(const mapped_document& copy) = delete;
+
+			std::shared_ptr<const mapped_file> file;
+			tokeniser_t   tokeniser;
+			tree_parser_t parser;
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "mapped_file.cpp"
+#endif
@@ -0,0 +1,193 @@
+#include "output_sink.h"
+
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+	#include <io.h>
+#else
+	#include <unistd.h>
+	#include <sys/uio.h>
+#endif
+
+namespace barnack::text_parser
+	{
+	template <typename output_char_t>
+	void rope_sink<output_char_t>::append(view_t string)
+		{
+		total_size += string.size();
+		while (!string.empty())
+			{
+			if (chunks.empty() || chunks.back().size() == chunk_capacity)
+				{
+				chunks.emplace_back().reserve(chunk_capacity);
+				}
+			auto& chunk{chunks.back()};
+			const size_t count{std::min(string.size(), chunk_capacity - chunk.size())};
+			chunk.append(string.substr(0, count));
+			string.remove_prefix(count);
+			}
+		}
+
+	template <typename output_char_t>
+	typename rope_sink<output_char_t>::string_t rope_sink<output_char_t>::to_string() const
+		{
+		string_t ret;
+		ret.reserve(total_size);
+		for (const auto& chunk : chunks) { ret += chunk; }
+		return ret;
+		}
+
+	template <typename output_char_t>
+	void rope_sink<output_char_t>::clear() noexcept
+		{
+		chunks.clear();
+		total_size = 0;
+		}
+
+	template <typename output_char_t>
+	void fixed_buffer_sink<output_char_t>::append(view_t string)
+		{
+		if (string.size() > buffer.size() - used)
+			{
+			throw std::length_error{"Error writing to fixed buffer output.\n"
+				"Output needs more than the buffer's " + std::to_string(buffer.size()) + " characters."};
+			}
+		std::ranges::copy(string, buffer.data() + used);
+		used += string.size();
+		}
+
+	template <typename output_char_t>
+	void spans_sink<output_char_t>::append(view_t string)
+		{
+		if (string.empty()) { return; }
+		total_size += string.size();
+
+		const bool is_persistent{!persistent.empty() && std::less_equal<>{}(persistent.data(), string.data()) && std::less_equal<>{}(string.data() + string.size(), persistent.data() + persistent.size())};
+		if (is_persistent)
+			{
+			add_span(string);
+			return;
+			}
+
+		while (!string.empty())
+			{
+			if (owned_chunks.empty() || owned_chunks.back().size() == owned_chunks.back().capacity())
+				{
+				owned_chunks.emplace_back().reserve(std::max(chunk_capacity, string.size()));
+				}
+			auto& chunk{owned_chunks.back()};
+			const size_t count{std::min(string.size(), chunk.capacity() - chunk.size())};
+			const size_t begin{chunk.size()};
+			chunk.append(string.substr(0, count));
+			add_span(view_t{chunk.data() + begin, count});
+			string.remove_prefix(count);
+			}
+		}
+
+	template <typename output_char_t>
+	void spans_sink<output_char_t>::add_span(view_t string)
+		{
+		if (!spans.empty() && spans.back().data() + spans.back().size() == string.data())
+			{
+			spans.back() = view_t{spans.back().data(), spans.back().size() + string.size()};
+			return;
+			}
+		spans.push_back(string);
+		}
+
+	template <typename output_char_t>
+	typename spans_sink<output_char_t>::string_t spans_sink<output_char_t>::to_string() const
+		{
+		string_t ret;
+		ret.reserve(total_size);
+		for (const auto& span : spans) { ret += span; }
+		return ret;
+		}
+
+	template <typename output_char_t>
+	void spans_sink<output_char_t>::clear() noexcept
+		{
+		spans.clear();
+		owned_chunks.clear();
+		total_size = 0;
+		}
+
+	template <typename output_char_t>
+	void spans_sink<output_char_t>::write_to(int file_descriptor) const
+		{
+		#ifdef _WIN32
+			for (const auto& span : spans)
+				{
+				const char* it{reinterpret_cast<const char*>(span.data())};
+				size_t remaining{span.size() * sizeof(output_char_t)};
+				while (remaining > 0)
+					{
+					const int written{::_write(file_descriptor, it, static_cast<unsigned int>(std::min<size_t>(remaining, INT_MAX)))};
+					if (written < 0) { throw std::system_error{errno, std::generic_category(), "Error writing output spans"}; }
+					it        += written;
+					remaining -= static_cast<size_t>(written);
+					}
+				}
+		#else
+			#ifdef IOV_MAX
+				constexpr size_t max_batch{IOV_MAX};
+			#else
+				constexpr size_t max_batch{1024};
+			#endif
+
+			std::vector<iovec> batch;
+			batch.reserve(std::min(spans.size(), max_batch));
+			size_t next_span{0};
+			while (next_span < spans.size() || !batch.empty())
+				{
+				while (batch.size() < max_batch && next_span < spans.size())
+					{
+					const auto& span{spans[next_span++]};
+					batch.push_back(iovec{const_cast<output_char_t*>(span.data()), span.size() * sizeof(output_char_t)});
+					}
+
+				const ssize_t written{::writev(file_descriptor, batch.data(), static_cast<int>(batch.size()))};
+				if (written < 0)
+					{
+					if (errno == EINTR) { continue; }
+					throw std::system_error{errno, std::generic_category(), "Error writing output spans"};
+					}
+
+				//Drops what was entirely written and advances into a partially written span.
+				size_t remaining{static_cast<size_t>(written)};
+				size_t done{0};
+				while (done < batch.size() && remaining >= batch[done].iov_len)
+					{
+					remaining -= batch[done].iov_len;
+					done++;
+					}
+				if (done < batch.size())
+					{
+					batch[done].iov_base = static_cast<std::byte*>(batch[done].iov_base) + remaining;
+					batch[done].iov_len -= remaining;
+					}
+				batch.erase(batch.begin(), batch.begin() + done);
+				}
+		#endif
+		}
+
+	template class output_sink<char16_t>;
+	template class output_sink<char8_t>;
+	template class output_sink<char>;
+	template class string_sink<char16_t>;
+	template class string_sink<char8_t>;
+	template class string_sink<char>;
+	template class rope_sink<char16_t>;
+	template class rope_sink<char8_t>;
+	template class rope_sink<char>;
+	template class fixed_buffer_sink<char16_t>;
+	template class fixed_buffer_sink<char8_t>;
+	template class fixed_buffer_sink<char>;
+	template class spans_sink<char16_t>;
+	template class spans_sink<char8_t>;
+	template class spans_sink<char>;
+	}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <span>
+#include <list>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <string_view>
+
+#include <utils/memory.h>
+
+namespace barnack::text_parser
+	{
+	//Destination of the text output by definitions, registered in the execution_context as output_sink<output_char_t>:
+	//	context.set_output<output_sink<output_char_t>>(std::addressof(sink));
+	//Regions offsets are expressed in characters appended to the sink.
+	template <typename OUTPUT_CHAR_T>
+	class output_sink
+		{
+		public:
+			using output_char_t = OUTPUT_CHAR_T;
+			using view_t        = std::basic_string_view<output_char_t>;
+			using string_t      = std::basic_string     <output_char_t>;
+
+			virtual ~output_sink() = default;
+
+			virtual void append(view_t string) = 0;
+			virtual size_t size() const noexcept = 0;
+		};
+
+	//Appends to a string owned by the caller.
+	template <typename OUTPUT_CHAR_T>
+	class string_sink : public output_sink<OUTPUT_CHAR_T>
+		{
+		public:
+			using view_t   = typename output_sink<OUTPUT_CHAR_T>::view_t;
+			using string_t = typename output_sink<OUTPUT_CHAR_T>::string_t;
+
+			string_sink(string_t& string) noexcept : string{string} {}
+
+			string_t& string;
+
+			virtual void append(view_t string) override { this->string.append(string); }
+			virtual size_t size() const noexcept override { return string.size(); }
+		};
+
+	//Sequence of fixed capacity chunks. Growing never moves what was already written.
+	template <typename OUTPUT_CHAR_T>
+	class rope_sink : public output_sink<OUTPUT_CHAR_T>
+		{
+		public:
+			using view_t   = typename output_sink<OUTPUT_CHAR_T>::view_t;
+			using string_t = typename output_sink<OUTPUT_CHAR_T>::string_t;
+
+			rope_sink(size_t chunk_capacity = 64 * 1024) noexcept : chunk_capacity{chunk_capacity > 0 ? chunk_capacity : 1} {}
+
+			std::vector<string_t> chunks;
+
+			virtual void append(view_t string) override;
+			virtual size_t size() const noexcept override { return total_size; }
+
+			string_t to_string() const;
+			void clear() noexcept;
+
+		private:
+			size_t chunk_capacity;
+			size_t total_size{0};
+		};
+
+	//Writes into a buffer provided by the caller, throws std::length_error instead of growing.
+	template <typename OUTPUT_CHAR_T>
+	class fixed_buffer_sink : public output_sink<OUTPUT_CHAR_T>
+		{
+		public:
+			using output_char_t = typename output_sink<OUTPUT_CHAR_T>::output_char_t;
+			using view_t        = typename output_sink<OUTPUT_CHAR_T>::view_t;
+
+			fixed_buffer_sink(std::span<output_char_t> buffer) noexcept : buffer{buffer} {}
+
+			virtual void append(view_t string) override;
+			virtual size_t size() const noexcept override { return used; }
+
+			view_t view() const noexcept { return {buffer.data(), used}; }
+			void clear() noexcept { used = 0; }
+
+		private:
+			std::span<output_char_t> buffer;
+			size_t used{0};
+		};
+
+	//Scatter-gather list of spans. Strings that lie within the persistent range, typically the source when input and output characters are the same type,
+	//are referred to instead of copied; anything else is copied into chunks owned by the sink. The persistent range must outlive the sink.
+	//Adjacent spans are merged, so consecutive raw ranges of the source end up as a single span.
+	template <typename OUTPUT_CHAR_T>
+	class spans_sink : public output_sink<OUTPUT_CHAR_T>
+		{
+		public:
+			using output_char_t = typename output_sink<OUTPUT_CHAR_T>::output_char_t;
+			using view_t        = typename output_sink<OUTPUT_CHAR_T>::view_t;
+			using string_t      = typename output_sink<OUTPUT_CHAR_T>::string_t;
+
+			spans_sink(view_t persistent = {}, size_t chunk_capacity = 4 * 1024) noexcept : persistent{persistent}, chunk_capacity{chunk_capacity > 0 ? chunk_capacity : 1} {}
+			spans_sink(const spans_sink& copy) = delete;
+			spans_sink& operator=(const spans_sink& copy) = delete;
+
+			std::vector<view_t> spans;
+
+			virtual void append(view_t string) override;
+			virtual size_t size() const noexcept override { return total_size; }
+
+			string_t to_string() const;
+			void clear() noexcept;
+			//Writes all the spans with as few writev calls as possible, retrying partial writes. Throws std::system_error on failure.
+			void write_to(int file_descriptor) const;
+
+		private:
+			view_t persistent;
+			size_t chunk_capacity;
+			size_t total_size{0};
+			//Chunks are reserved once and never grow past their capacity, so spans into them stay valid. List nodes don't move.
+			std::list<string_t> owned_chunks;
+
+			void add_span(view_t string);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "output_sink.cpp"
+#endif
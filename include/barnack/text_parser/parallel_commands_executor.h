@@ -0,0 +1,245 @@
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <string>
+#include <vector>
+#include <variant>
+#include <exception>
+
+#include <utils/memory.h>
+#include <utils/containers/regions.h>
+
+#include "tree_parser.h"
+#include "flat_tree.h"
+#include "commands_executor.h"
+#include "execution_context.h"
+#include "region_output.h"
+#include "output_sink.h"
+#include "thread_pool.h"
+
+namespace barnack::text_parser
+	{
+	//Executes the children of commands whose whole subtree is made of reentrant definitions on multiple threads.
+	//Each task executes with a copy of the context whose output sink and region output are the task's own, and those are appended to the context's ones in document order once all tasks are done.
+	//Commands with non reentrant definitions are executed on the calling thread, looking for parallelizable subtrees among their children.
+	//Reentrant definitions must not write to outputs of other types than those two, tasks share them.
+	template <typename CHAR_T, typename OUTPUT_CHAR_T, typename REGIONS_VALUE_TYPE>
+	class parallel_commands_executor
+		{
+		public:
+			using char_t               = CHAR_T;
+			using output_char_t        = OUTPUT_CHAR_T;
+			using output_string_t      = std::basic_string<output_char_t>;
+			using output_sink_t        = output_sink<output_char_t>;
+			using regions_value_type   = REGIONS_VALUE_TYPE;
+			using regions_t            = utils::containers::regions<regions_value_type>;
+			using region_fragment_t    = region_fragment<regions_value_type>;
+			using region_output_t      = region_output<regions_value_type>;
+			using range_t              = typename tokeniser<char_t>::range;
+			using input_command_t      = typename tree_parser<char_t>::command;
+			using input_command_view_t = typename flat_tree<char_t>::command_view;
+			using range_view_t         = typename flat_tree<char_t>::range_view;
+
+			parallel_commands_executor(text_parser::commands_executor<char_t>& commands_executor) : commands_executor{commands_executor} {}
+
+			//The threads are created by the first parallel execution, and again if this changes.
+			size_t threads_count{std::thread::hardware_concurrency()};
+			//Subtrees with less elements than this are not worth splitting.
+			size_t min_parallel_elements{256};
+
+			void execute(const input_command_t     & input_command, execution_context<char_t>& context) { execute_root(input_command, context); }
+			void execute(const input_command_view_t& input_command, execution_context<char_t>& context) { execute_root(input_command, context); }
+
+		private:
+			text_parser::commands_executor<char_t>& commands_executor;
+			std::unique_ptr<thread_pool> pool_ptr;
+
+			struct subtree_info
+				{
+				bool reentrant{false};
+				//Elements the executor visits in the subtree, to decide whether it's worth splitting.
+				size_t elements_count{0};
+				//Entries of the subtree's commands following the command's own one.
+				size_t descendants_count{0};
+				};
+			//One entry per command the executor visits, in the order it visits them.
+			using subtrees_t = std::vector<subtree_info>;
+
+			//Raw children are reported as tokeniser ranges by tree_parser trees and as range views by flat trees.
+			template <typename T>
+			static constexpr bool is_raw{std::same_as<T, range_t> || std::same_as<T, range_view_t>};
+
+			static void for_each_child(const input_command_t& command, auto&& callback)
+				{
+				tree_parser<char_t>::for_each_element(command.children, [&](const typename tree_parser<char_t>::sequence_element& element)
+					{
+					if (const auto child_command_ptr{std::get_if<input_command_t>(&element)}) { callback(*child_command_ptr); }
+					else { callback(std::get<range_t>(element)); }
+					});
+				}
+			static void for_each_child(const input_command_view_t& command, auto&& callback)
+				{
+				for (const auto& child : command.children)
+					{
+					if (child.is_command()) { callback(child.command()); }
+					else { callback(child.range()); }
+					}
+				}
+
+			//Appends the entries of the subtree's commands, each one computed from its children's so the whole tree is walked once.
+			void analyse(const auto& command, subtrees_t& subtrees, bool all_reentrant)
+				{
+				const size_t index{subtrees.size()};
+				subtrees.emplace_back();
+
+				const auto command_definition_ptr{commands_executor.try_find_command_definition(command.name.string(), command.name_symbol)};
+				const bool visits_children{command_definition_ptr && command_definition_ptr->execute_child_commands()};
+				const bool reentrant{command_definition_ptr && command_definition_ptr->reentrant() && (all_reentrant || !command_definition_ptr->executes_other_definitions())};
+				subtree_info info{.reentrant{reentrant}, .elements_count{0}, .descendants_count{0}};
+				for_each_child(command, [&](const auto& child)
+					{
+					info.elements_count++;
+					if constexpr (!is_raw<std::remove_cvref_t<decltype(child)>>)
+						{
+						if (!visits_children) { return; }
+						const size_t child_index{subtrees.size()};
+						analyse(child, subtrees, all_reentrant);
+						info.reentrant       = info.reentrant && subtrees[child_index].reentrant;
+						info.elements_count += subtrees[child_index].elements_count;
+						}
+					});
+				info.descendants_count = subtrees.size() - index - 1;
+				subtrees[index] = info;
+				}
+
+			template <typename command_t>
+			void execute_root(const command_t& input_command, execution_context<char_t>& context)
+				{
+				if (threads_count < 2)
+					{
+					commands_executor.execute(input_command, context);
+					return;
+					}
+				if (!pool_ptr || pool_ptr->threads_count() != threads_count) { pool_ptr = std::make_unique<thread_pool>(threads_count); }
+
+				subtrees_t subtrees;
+				analyse(input_command, subtrees, commands_executor.all_reentrant());
+				size_t cursor{0};
+				execute_command(input_command, context, subtrees, cursor);
+				}
+
+			//Visits commands in the same order as analyse, cursor is the index of input_command's entry.
+			template <typename command_t>
+			void execute_command(const command_t& input_command, execution_context<char_t>& context, const subtrees_t& subtrees, size_t& cursor)
+				{
+				auto& command_definition{commands_executor.find_command_definition(input_command.name, input_command.name_symbol)};
+
+				const subtree_info& info{subtrees[cursor++]};
+				const bool parallel{info.reentrant && info.elements_count >= min_parallel_elements};
+				if (parallel)
+					{
+					command_definition.validate(input_command, context);
+					command_definition.on_begin(input_command, context);
+					execute_children_parallel(command_definition, input_command, context);
+					command_definition.on_end(input_command, context);
+					cursor += info.descendants_count;
+					return;
+					}
+
+				command_definition.validate(input_command, context);
+				command_definition.on_begin(input_command, context);
+				for_each_child(input_command, [&](const auto& child)
+					{
+					command_definition.on_child(input_command, child, context);
+					if constexpr (!is_raw<std::remove_cvref_t<decltype(child)>>)
+						{
+						if (command_definition.execute_child_commands()) { execute_command(child, context, subtrees, cursor); }
+						}
+					});
+				command_definition.on_end(input_command, context);
+				}
+
+			template <typename command_t>
+			void execute_children_parallel(command_definition::base<char_t>& command_definition, const command_t& input_command, execution_context<char_t>& context)
+				{
+				using child_command_t = std::conditional_t<std::same_as<command_t, input_command_t>, utils::observer_ptr<const input_command_t>, input_command_view_t>;
+				using child_range_t   = std::conditional_t<std::same_as<command_t, input_command_t>, range_t, range_view_t>;
+				using child_t = std::variant<child_command_t, child_range_t>;
+
+				std::vector<child_t> children;
+				for_each_child(input_command, [&](const auto& child)
+					{
+					if constexpr (is_raw<std::remove_cvref_t<decltype(child)>>) { children.emplace_back(child); }
+					else if constexpr (std::same_as<command_t, input_command_t>) { children.emplace_back(std::in_place_index<0>, std::addressof(child)); }
+					else { children.emplace_back(std::in_place_index<0>, child); }
+					});
+
+				struct task
+					{
+					size_t children_begin;
+					size_t children_end;
+					output_string_t output_string;
+					region_fragment_t region_fragment;
+					std::exception_ptr error;
+					};
+				const size_t tasks_count{std::min(threads_count, children.size())};
+				std::vector<task> tasks(tasks_count);
+				for (size_t i{0}; i < tasks_count; i++)
+					{
+					tasks[i].children_begin = children.size() *  i      / tasks_count;
+					tasks[i].children_end   = children.size() * (i + 1) / tasks_count;
+					}
+
+				const auto run_task{[&](task& task)
+					{
+					try
+						{
+						string_sink<output_char_t> task_output_sink{task.output_string};
+						region_output_t task_region_output{task.region_fragment};
+						execution_context<char_t> task_context{context};
+						if (context.template output<output_sink_t  >()) { task_context.template set_output<output_sink_t>(std::addressof(task_output_sink)); }
+						if (context.template output<region_output_t>()) { task_context.set_output(std::addressof(task_region_output)); }
+
+						for (size_t i{task.children_begin}; i < task.children_end; i++)
+							{
+							if (const auto child_range_ptr{std::get_if<child_range_t>(&children[i])})
+								{
+								command_definition.on_child(input_command, *child_range_ptr, task_context);
+								continue;
+								}
+
+							const command_t& child_command{[&]() -> const command_t&
+								{
+								if constexpr (std::same_as<command_t, input_command_t>) { return *std::get<child_command_t>(children[i]); }
+								else { return std::get<child_command_t>(children[i]); }
+								}()};
+							command_definition.on_child(input_command, child_command, task_context);
+							if (command_definition.execute_child_commands()) { commands_executor.execute(child_command, task_context); }
+							}
+						}
+					catch (...)
+						{
+						task.error = std::current_exception();
+						}
+					}};
+
+				pool_ptr->for_each_index(tasks_count, [&](size_t index, size_t) { run_task(tasks[index]); });
+
+				for (const auto& task : tasks)
+					{
+					if (task.error) { std::rethrow_exception(task.error); }
+					}
+
+				const auto output_sink_ptr  {context.template output<output_sink_t  >()};
+				const auto output_region_ptr{context.template output<region_output_t>()};
+				if (!output_sink_ptr) { return; }
+				for (const auto& task : tasks)
+					{
+					const size_t base_offset{output_sink_ptr->size()};
+					output_sink_ptr->append(task.output_string);
+					if (output_region_ptr) { output_region_ptr->append(task.region_fragment, base_offset); }
+					}
+				}
+		};
+	}
@@ -0,0 +1,239 @@
+#include "parser_base.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	void parser_base<char_t>::parse_all(tokeniser_t& tokeniser)
+		{
+		typename tokeniser_t::iterator_with_info it{tokeniser.begin_with_info()};
+		while (it.it != tokeniser.end())
+			{
+			it = step(tokeniser, it);
+			}
+		}
+
+	template <typename char_t>
+	void parser_base<char_t>::parse_all(tokeniser_t& tokeniser, const structural_index<char_t>& structural_index)
+		{
+		if (structural_index.string_size != tokeniser.string.size())
+			{
+			throw std::logic_error{"The structural index passed to parse_all was not built from the tokeniser's string."};
+			}
+
+		structural_index_ptr = std::addressof(structural_index);
+		structural_index_cursor = 0;
+		try
+			{
+			parse_all(tokeniser);
+			}
+		catch (...)
+			{
+			structural_index_ptr = nullptr;
+			throw;
+			}
+		structural_index_ptr = nullptr;
+		}
+
+	template <typename char_t>
+	typename parser_base<char_t>::tokeniser_t::iterator_with_info parser_base<char_t>::step(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+		{
+		const auto first_codepoint{tokeniser.next_codepoint(begin)};
+		if (first_codepoint.codepoint == U'}')
+			{
+			if (open_bodies_count == 0)
+				{
+				throw std::runtime_error{"Curly brackets closed found without there being a matched opening.\n" + begin.to_string()};
+				}
+			open_bodies_count--;
+			on_body_end();
+			return first_codepoint.range.end;
+			}
+		else if (first_codepoint.codepoint == U'\\')
+			{
+			return step_command(tokeniser, first_codepoint.range.end);
+			}
+		else 
+			{
+			return step_raw(tokeniser, begin);
+			}
+		}
+
+
+	template <typename char_t>
+	typename parser_base<char_t>::tokeniser_t::iterator_with_info parser_base<char_t>::step_raw(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+		{
+		const typename tokeniser_t::range raw_text{[&]()
+			{
+			if (structural_index_ptr)
+				{
+				//Only '}' and '\\' end raw text, the other structural characters are content here.
+				const auto& positions{structural_index_ptr->positions};
+				const size_t begin_index{static_cast<size_t>(begin.it - tokeniser.begin())};
+				while (structural_index_cursor < positions.size())
+					{
+					const size_t position{positions[structural_index_cursor]};
+					if (position >= begin_index)
+						{
+						const char_t structural_char{tokeniser.string[position]};
+						if (structural_char == static_cast<char_t>('}') || structural_char == static_cast<char_t>('\\')) { break; }
+						}
+					structural_index_cursor++;
+					}
+				const typename tokeniser_t::iterator end{structural_index_cursor < positions.size() ? tokeniser.begin() + positions[structural_index_cursor] : tokeniser.end()};
+				return tokeniser.next_to(begin, end);
+				}
+
+			return tokeniser.next_until(begin, [](const tokeniser_t::codepoint_with_range& cpwr) -> bool
+				{
+				const auto ret{cpwr.codepoint == U'}' || cpwr.codepoint == U'\\'};
+				return ret;
+				});
+			}()};
+
+		//Only called if the first character is already valid as raw content, so the raw_text view should never be empty.
+		if(true && !raw_text.empty())
+			{
+			assert(!raw_text.empty());//If this ever triggers (it shouldn't) remove the true from above. Or try to understand why it's happening to begin with.
+			on_raw(raw_text);
+			}
+
+		return {raw_text.end};
+		}
+
+
+	template <typename char_t>
+	typename parser_base<char_t>::tokeniser_t::iterator_with_info parser_base<char_t>::step_command(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+		{
+		const typename tokeniser_t::range command_name{tokeniser.next_identifier(begin)};
+
+		//Only called if the first character is already valid as raw content, so the raw_text view should never be empty.
+		if (command_name.empty())
+			{
+			throw std::runtime_error
+				{
+				"Empty command. \"\\\" should be followed by a valid identifier\n"
+				"An identifier is a sequence of lower or upper case latin alphabet non-decorated letters, arabic numerals, and underscores.\n"
+				"It also cannot begin with arabic numerals.\n"
+				"Examples: \n"
+				"\t\\something;\n" 
+				"\t\\stuff_123\n" +
+				begin.to_string()
+				};
+			}
+
+		on_command_begin(command_name, symbol_table_ptr ? symbol_table_ptr->find(command_name.string()) : symbol_table::none);
+
+		auto next_codepoint{tokeniser.next_codepoint(command_name.end)};
+		if (next_codepoint.codepoint == U'(')
+			{
+			const auto step_parameters_end{step_parameters(tokeniser, next_codepoint.range.end)};
+			next_codepoint = tokeniser.next_codepoint(step_parameters_end);
+			}
+
+		if (next_codepoint.codepoint == U'{')
+			{
+			open_bodies_count++;
+			on_body_begin();
+			return next_codepoint.range.end;
+			}
+		else if(next_codepoint.codepoint == U';')
+			{
+			on_command_end();
+			return next_codepoint.range.end;
+			}
+		else
+			{
+			throw std::runtime_error
+				{
+				"Invalid command termination.\n"
+				"Commands should be either followed by a curly brackets enclosed block, or a semicolon\n"
+				"Examples: \n"
+				"\t\\command;\n" 
+				"\t\\command{content}\n" 
+				"\t\\command(paramters);\n"
+				"\t\\command(paramters){content}\n" +
+				begin.to_string()
+				};
+			}
+		}
+
+
+	template <typename char_t>
+	typename parser_base<char_t>::parameter parser_base<char_t>::next_parameter(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+		{
+		typename tokeniser_t::token ret{tokeniser.next_token(begin, strings)};
+		if (ret.kind == tokeniser_t::token_kind::identifier)
+			{
+			const symbol_t symbol{symbol_table_ptr ? symbol_table_ptr->find(ret.string()) : symbol_table::none};
+			return {std::move(ret), symbol};
+			}
+		if (ret.kind == tokeniser_t::token_kind::none)
+			{
+			throw std::runtime_error
+				{
+				"Invalid command parameter. Command parameters must be valid identifier, a string, or number\n"
+				"An identifier is a sequence of lower or upper case latin alphabet non-decorated letters, arabic numerals, and underscores.\n"
+				"A string is a sequence of characters enclosed in quotation marks. A backspace can be used to escape the quotation marks symbols and continue the string.\n"
+				"A number is a sequence of arabic numerals, with one or no dot as decimal separator, optionally preceded by a sign and followed by an exponent.\n"
+				"Examples: \n"
+				"\tparam\n"
+				"\tparam_qwerty_456\n"
+				"\t\"string!\"\n"
+				"\t\"string with a \\\"quotation\\\" symbol inside\"\n"
+				"\t123456\n"
+				"\t123.456\n"
+				"\t.123\n"
+				"\t123.\n"
+				"\t-1.5e3\n" +
+				begin.to_string()
+				};
+			}
+		return {std::move(ret)};
+		}
+
+
+	template <typename char_t>
+	typename parser_base<char_t>::tokeniser_t::iterator_with_info parser_base<char_t>::step_parameters(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+		{
+		typename tokeniser_t::iterator_with_info it{begin};
+				
+		while (true)
+			{
+			it = tokeniser.next_whitespace(it).end;
+			const auto parameter{next_parameter(tokeniser, it)};
+			it = parameter.end;
+			on_parameter(parameter);
+			it = tokeniser.next_whitespace(it).end;
+			const auto next_codepoint{tokeniser.next_codepoint(it)};
+			if (next_codepoint.codepoint == U')')
+				{
+				return next_codepoint.range.end;
+				}
+			if (next_codepoint.codepoint == U',')
+				{
+				it = next_codepoint.range.end;
+				}
+			else
+				{
+				throw std::runtime_error
+					{
+					"Invalid command parameters. Command parameters must be a round brackets enclosed sequence of comma separated valid identifiers or numbers\n"
+					"An identifier is a sequence of lower or upper case latin alphabet non-decorated letters, arabic numerals, and underscores.\n"
+					"A number is a sequence of arabic numerals, with one or no dot as decimal separator.\n"
+					"A comma is \",\" :)\n"
+					"Examples: \n"
+					"\t(param, param_qwerty_456, 123456)\n"
+					"\t(123.456, .123, 123.)\n" +
+					begin.to_string()
+					};
+				}
+			}
+		}
+
+	template class parser_base<char16_t>;
+	template class parser_base<char8_t>;
+	template class parser_base<char>;
+	}
\ No newline at end of file
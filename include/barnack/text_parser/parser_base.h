@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+
+#include <utils/string.h>
+#include <utils/memory.h>
+
+#include "tokeniser.h"
+#include "structural_index.h"
+#include "symbol_table.h"
+#include "string_arena.h"
+
+namespace barnack::text_parser
+	{
+	//Bumped whenever the same source may parse into a different tree, so that trees persisted by earlier versions are not reused.
+	inline constexpr uint32_t parser_version{1};
+
+	//Recognises the document structure and reports it as a sequence of events, leaving it to derived classes to decide what to build out of them.
+	//A command begins with on_command_begin, followed by one on_parameter per parameter.
+	//It then either ends right away with on_command_end (semicolon terminated), or opens a body with on_body_begin which is closed by the matching on_body_end.
+	template <typename CHAR_T>
+	class parser_base
+		{
+		public:
+			using char_t         = CHAR_T;
+			using view_t         = std::basic_string_view <char_t>;
+			using string_t       = std::basic_string      <char_t>;
+			using stringstream_t = std::basic_stringstream<char_t>;
+			using tokeniser_t    = tokeniser<char_t>;
+			using symbol_t       = symbol_table::symbol_t;
+
+			struct parameter : tokeniser_t::token
+				{
+				//Set for identifiers found in the symbol table.
+				symbol_t symbol{symbol_table::none};
+				};
+
+			virtual ~parser_base() = default;
+
+			//When set, command names and identifier parameters are looked up in this table and their symbols stored alongside their ranges.
+			//It must be the table of the commands_executor the result will be executed with.
+			utils::observer_ptr<const symbol_table> symbol_table_ptr{nullptr};
+
+			//Decoded string parameters that had escape sequences, the other ones are views of the source. Part of the parse result like the source is.
+			string_arena<char_t> strings;
+
+			void parse_all(tokeniser_t& tokeniser);
+			//Raw text is skipped by jumping to the next structural character found by the index instead of decoding it. The index must be built from the same string as the tokeniser.
+			void parse_all(tokeniser_t& tokeniser, const structural_index<char_t>& structural_index);
+
+		protected:
+			virtual void on_raw          (const typename tokeniser_t::range& raw_text ) = 0;
+			virtual void on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol) = 0;
+			virtual void on_parameter    (const parameter& parameter) = 0;
+			virtual void on_command_end  () {}
+			virtual void on_body_begin   () = 0;
+			virtual void on_body_end     () = 0;
+
+			//Bodies opened and not yet closed. Persists across parse_all calls, so a body can be opened by a string and closed by another one.
+			size_t open_bodies_count{0};
+
+		private:
+			utils::observer_ptr<const structural_index<char_t>> structural_index_ptr{nullptr};
+			size_t structural_index_cursor{0};
+
+			typename tokeniser_t::iterator_with_info step           (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
+			typename tokeniser_t::iterator_with_info step_raw       (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
+			typename tokeniser_t::iterator_with_info step_command   (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
+			parameter                                next_parameter (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
+			typename tokeniser_t::iterator_with_info step_parameters(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "parser_base.cpp"
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include <utils/memory.h>
+#include <utils/containers/regions.h>
+
+namespace barnack::text_parser
+	{
+	//Regions changes made by a task, with offsets relative to the task's output. Appended to the shared regions once the task's output is appended.
+	template <typename VALUE_T>
+	struct region_fragment
+		{
+		using value_t = VALUE_T;
+
+		struct operation
+			{
+			//Ends restore the value that was there before the matching begin, which is only known when appending.
+			bool is_begin;
+			value_t value;
+			size_t offset;
+			};
+		std::vector<operation> operations;
+		};
+
+	//Where region_properties definitions write, registered as an output of the execution_context.
+	//Either writes to regions directly, or records changes in a fragment when executing a task whose output will be appended elsewhere later.
+	template <typename VALUE_T>
+	class region_output
+		{
+		public:
+			using value_t    = VALUE_T;
+			using regions_t  = utils::containers::regions<value_t>;
+			using fragment_t = region_fragment<value_t>;
+
+			region_output(regions_t & regions ) noexcept : regions_ptr {std::addressof(regions )} {}
+			region_output(fragment_t& fragment) noexcept : fragment_ptr{std::addressof(fragment)} {}
+
+			void begin(const value_t& value, size_t offset)
+				{
+				if (fragment_ptr)
+					{
+					fragment_ptr->operations.push_back({true, value, offset});
+					return;
+					}
+				previous_values.push_back(regions_ptr->at_element_index(offset).value());
+				regions_ptr->add(value, utils::containers::region::create::from(offset));
+				}
+
+			void end(size_t offset)
+				{
+				if (fragment_ptr)
+					{
+					fragment_ptr->operations.push_back({false, value_t{}, offset});
+					return;
+					}
+				if (previous_values.empty()) { return; }
+				regions_ptr->add(previous_values.back(), utils::containers::region::create::from(offset));
+				previous_values.pop_back();
+				}
+
+			//Applies the changes of a task whose output was appended at base_offset.
+			void append(const fragment_t& fragment, size_t base_offset)
+				{
+				for (const auto& operation : fragment.operations)
+					{
+					if (operation.is_begin) { begin(operation.value, base_offset + operation.offset); }
+					else { end(base_offset + operation.offset); }
+					}
+				}
+
+		private:
+			utils::observer_ptr<regions_t > regions_ptr {nullptr};
+			utils::observer_ptr<fragment_t> fragment_ptr{nullptr};
+			//Values to restore when the currently open regions end, innermost last.
+			std::vector<value_t> previous_values;
+		};
+	}
@@ -0,0 +1,171 @@
+#include "replacement_template.h"
+
+#include <stdexcept>
+
+namespace barnack::text_parser
+	{
+	namespace details
+		{
+		template <typename char_t>
+		class replacement_template_recorder : public parser_base<char_t>
+			{
+			public:
+				using tokeniser_t = typename parser_base<char_t>::tokeniser_t;
+				using symbol_t    = typename parser_base<char_t>::symbol_t;
+				using parameter   = typename parser_base<char_t>::parameter;
+				using template_t  = replacement_template<char_t>;
+				using event       = typename template_t::event;
+
+				//Holes' indices are offsets from source_begin, sorted.
+				replacement_template_recorder(const char_t* source_begin, const std::vector<typename template_t::hole>& holes, std::vector<event>& events) :
+					source_begin{source_begin}, holes{holes}, events{events} {}
+
+			protected:
+				virtual void on_raw(const typename tokeniser_t::range& raw_text) override
+					{
+					const size_t raw_begin{offset_of(raw_text.begin.it)};
+					const size_t raw_end  {offset_of(raw_text.end  .it)};
+					const tokeniser_t tokeniser{raw_text.string()};
+
+					typename tokeniser_t::iterator_with_info it{raw_text.begin};
+					for (const auto& hole : holes)
+						{
+						if (hole.index_end <= raw_begin || hole.index_begin >= raw_end) { continue; }
+						if (hole.index_begin < raw_begin || hole.index_end > raw_end) { throw_unrepresentable(); }
+
+						const auto literal{tokeniser.next_to(it, source_begin + hole.index_begin)};
+						if (!literal.empty()) { events.push_back(event{.kind{event::kind_t::raw}, .range{literal}}); }
+
+						const auto hole_range{tokeniser.next_to(literal.end, source_begin + hole.index_end)};
+						events.push_back(event{.kind{event::kind_t::raw}, .range{hole_range}, .parameter_index{hole.parameter_index}});
+						it = hole_range.end;
+						}
+
+					const auto literal{tokeniser.next_to(it, raw_text.end.it)};
+					if (!literal.empty()) { events.push_back(event{.kind{event::kind_t::raw}, .range{literal}}); }
+					}
+
+				virtual void on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol) override
+					{
+					if (find_overlapping_hole(name)) { throw_unrepresentable(); }
+					events.push_back(event{.kind{event::kind_t::command_begin}, .range{name}});
+					}
+
+				virtual void on_parameter(const parameter& parameter) override
+					{
+					const auto hole_ptr{find_overlapping_hole(parameter)};
+					if (!hole_ptr)
+						{
+						events.push_back(event{.kind{event::kind_t::parameter}, .range{parameter}, .parameter_kind{parameter.kind}, .parameter_value{parameter.value}});
+						return;
+						}
+
+					const bool whole_parameter{hole_ptr->index_begin == offset_of(parameter.begin.it) && hole_ptr->index_end == offset_of(parameter.end.it)};
+					if (!whole_parameter) { throw_unrepresentable(); }
+					events.push_back(event{.kind{event::kind_t::parameter}, .range{parameter}, .parameter_index{hole_ptr->parameter_index}});
+					}
+
+				virtual void on_body_begin() override { events.push_back(event{.kind{event::kind_t::body_begin}}); }
+				virtual void on_body_end  () override { events.push_back(event{.kind{event::kind_t::body_end  }}); }
+
+			private:
+				const char_t* source_begin;
+				const std::vector<typename template_t::hole>& holes;
+				std::vector<event>& events;
+
+				size_t offset_of(const typename tokeniser_t::iterator& it) const noexcept { return static_cast<size_t>(it - source_begin); }
+
+				utils::observer_ptr<const typename template_t::hole> find_overlapping_hole(const typename tokeniser_t::range& range) const noexcept
+					{
+					const size_t range_begin{offset_of(range.begin.it)};
+					const size_t range_end  {offset_of(range.end  .it)};
+					for (const auto& hole : holes)
+						{
+						if (hole.index_end > range_begin && hole.index_begin < range_end) { return std::addressof(hole); }
+						}
+					return nullptr;
+					}
+
+				[[noreturn]] static void throw_unrepresentable()
+					{
+					throw std::runtime_error{"Replacement parameter is part of a command name or of a parameter."};
+					}
+			};
+		}
+
+	template <typename char_t>
+	void replacement_template<char_t>::compile(view_t before_body_prototype, const std::vector<hole>& before_body_holes, view_t after_body_prototype, const std::vector<hole>& after_body_holes)
+		{
+		//Any identifier works as placeholder, what matters is where holes end up, which is tracked by offset.
+		constexpr char_t placeholder{static_cast<char_t>('_')};
+
+		string_t compiled_source;
+		std::vector<hole> holes;
+		const auto append_prototype{[&](view_t prototype, const std::vector<hole>& prototype_holes)
+			{
+			size_t it{0};
+			for (const auto& prototype_hole : prototype_holes)
+				{
+				compiled_source += prototype.substr(it, prototype_hole.index_begin - it);
+				holes.push_back(hole{prototype_hole.parameter_index, compiled_source.size(), compiled_source.size() + 1});
+				compiled_source += placeholder;
+				it = prototype_hole.index_end;
+				}
+			compiled_source += prototype.substr(it);
+			}};
+
+		append_prototype(before_body_prototype, before_body_holes);
+		const size_t before_body_size{compiled_source.size()};
+		append_prototype(after_body_prototype, after_body_holes);
+
+		source = std::make_shared<const string_t>(std::move(compiled_source));
+		const view_t source_view{*source};
+
+		events.clear();
+		raw_holes_parameters_indices.clear();
+		try
+			{
+			details::replacement_template_recorder<char_t> recorder{source_view.data(), holes, events};
+
+			tokeniser_t tokeniser_before_body{source_view.substr(0, before_body_size)};
+			tokeniser_t tokeniser_after_body {source_view.substr(before_body_size)};
+
+			recorder.parse_all(tokeniser_before_body);
+			events.push_back(event{.kind{event::kind_t::body}});
+			recorder.parse_all(tokeniser_after_body);
+			strings = std::make_shared<const string_arena<char_t>>(std::move(recorder.strings));
+			}
+		catch (const std::exception&)
+			{
+			//Errors are reported when the generated string is parsed on invocation.
+			events.clear();
+			is_compiled = false;
+			return;
+			}
+
+		for (const auto& recorded : events)
+			{
+			if (recorded.kind == event::kind_t::raw && recorded.parameter_index != no_parameter)
+				{
+				raw_holes_parameters_indices.push_back(recorded.parameter_index);
+				}
+			}
+		is_compiled = true;
+		}
+
+	template <typename char_t>
+	void replacement_template<char_t>::intern_symbols(const symbol_table& symbols)
+		{
+		auto& table_events_symbols{events_symbols[symbols]};
+		table_events_symbols.clear();
+		for (const auto& recorded : events)
+			{
+			const bool literal_name_or_parameter{recorded.kind == event::kind_t::command_begin || (recorded.kind == event::kind_t::parameter && recorded.parameter_index == no_parameter)};
+			table_events_symbols.push_back(literal_name_or_parameter ? symbols.find(recorded.range.string()) : symbol_table::none);
+			}
+		}
+
+	template class replacement_template<char16_t>;
+	template class replacement_template<char8_t>;
+	template class replacement_template<char>;
+	}
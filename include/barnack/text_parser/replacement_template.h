@@ -0,0 +1,147 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include <utils/memory.h>
+
+#include "tokeniser.h"
+#include "parser_base.h"
+#include "tree_parser.h"
+#include "symbol_table.h"
+
+namespace barnack::text_parser
+	{
+	//Replacement prototypes parsed once into the sequence of parser events they produce, with the "\#N" parameters left as holes.
+	//Binding a command replays the events into a tree, taking holes from the command's parameters, instead of generating and parsing the replacement string again.
+	//Raw text is split around holes, so hooks see separate raw ranges where the generated string would have one.
+	template <typename CHAR_T>
+	class replacement_template
+		{
+		public:
+			using char_t      = CHAR_T;
+			using view_t      = std::basic_string_view<char_t>;
+			using string_t    = std::basic_string     <char_t>;
+			using tokeniser_t = tokeniser<char_t>;
+			using command_t   = typename tree_parser<char_t>::command;
+			using sequence_t  = typename tree_parser<char_t>::sequence;
+			using parameter   = typename parser_base<char_t>::parameter;
+			using symbol_t    = symbol_table::symbol_t;
+
+			static constexpr size_t no_parameter{std::numeric_limits<size_t>::max()};
+
+			struct event
+				{
+				enum class kind_t { raw, command_begin, parameter, body_begin, body_end, body };
+				kind_t kind;
+				//Literal text, command name or literal parameter.
+				typename tokeniser_t::range range{};
+				typename tokeniser_t::token_kind parameter_kind{tokeniser_t::token_kind::none};
+				typename tokeniser_t::value_t parameter_value{};
+				//Raw text and parameters taken from the invoked command's parameters.
+				size_t parameter_index{no_parameter};
+				};
+
+			struct hole
+				{
+				size_t parameter_index;
+				size_t index_begin;
+				size_t index_end;
+				};
+
+			//Takes replacement_pieces, reading their prototype and "\#N" ranges.
+			replacement_template(const auto& before_body_piece, const auto& after_body_piece)
+				{
+				const auto holes_of{[](const auto& piece)
+					{
+					std::vector<hole> ret;
+					for (const auto& range : piece.replacement_parameters_ranges) { ret.push_back(hole{range.parameter_index, range.index_begin, range.index_end}); }
+					return ret;
+					}};
+				compile(before_body_piece.replacement_string_prototype, holes_of(before_body_piece), after_body_piece.replacement_string_prototype, holes_of(after_body_piece));
+				}
+
+			//False when a parameter is part of a command name, or only part of a parameter, or a prototype doesn't parse.
+			//Those replacements have to be generated and parsed for every invocation.
+			bool compiled() const noexcept { return is_compiled; }
+
+			//Resolves the symbols of literal command names and identifiers in the table of an executor commands will be executed with.
+			//Each table keeps its own symbols, the template can be registered with several executors.
+			void intern_symbols(const symbol_table& symbols);
+
+			//Parameters substituted within raw text must not contain characters which would end it.
+			bool can_bind(const auto& command) const noexcept
+				{
+				if (!is_compiled) { return false; }
+				for (const size_t parameter_index : raw_holes_parameters_indices)
+					{
+					const view_t string{command.parameters[parameter_index].string()};
+					const bool has_syntax{std::ranges::any_of(string, [](char_t code_unit) { return code_unit == static_cast<char_t>('\\') || code_unit == static_cast<char_t>('}'); })};
+					if (has_syntax) { return false; }
+					}
+				return true;
+				}
+
+			//Root command whose children are the replacement, insert_body(sequence) is called where the invoked command's body goes.
+			//Names and identifiers get their symbols in symbols, the table of the executor the result is executed with, or none if it wasn't interned.
+			command_t bind(const auto& command, const symbol_table& symbols, auto&& insert_body) const
+				{
+				const auto events_symbols_ptr{events_symbols.find(symbols)};
+				const auto symbol_of{[&events_symbols_ptr](size_t event_index) { return events_symbols_ptr ? (*events_symbols_ptr)[event_index] : symbol_table::none; }};
+
+				command_t root;
+				std::vector<utils::observer_ptr<sequence_t>> sequences_stack{std::addressof(root.children)};
+				utils::observer_ptr<command_t> last_command_ptr{nullptr};
+
+				for (size_t event_index{0}; event_index < events.size(); event_index++)
+					{
+					const auto& current{events[event_index]};
+					auto& topmost_sequence{*sequences_stack.back()};
+					switch (current.kind)
+						{
+						case event::kind_t::raw:
+							if (current.parameter_index == no_parameter) { topmost_sequence.emplace_back(current.range); }
+							else { topmost_sequence.emplace_back(static_cast<typename tokeniser_t::range>(command.parameters[current.parameter_index])); }
+							break;
+						case event::kind_t::command_begin:
+							last_command_ptr = std::addressof(std::get<command_t>(topmost_sequence.emplace_back(command_t{.name{current.range}, .name_symbol{symbol_of(event_index)}, .parameters{}, .children{}})));
+							break;
+						case event::kind_t::parameter:
+							if (current.parameter_index == no_parameter) { last_command_ptr->parameters.push_back(parameter{{current.range, current.parameter_kind, current.parameter_value}, symbol_of(event_index)}); }
+							else { last_command_ptr->parameters.push_back(static_cast<parameter>(command.parameters[current.parameter_index])); }
+							break;
+						case event::kind_t::body_begin:
+							sequences_stack.push_back(std::addressof(last_command_ptr->children));
+							break;
+						case event::kind_t::body_end:
+							sequences_stack.pop_back();
+							break;
+						case event::kind_t::body:
+							insert_body(topmost_sequence);
+							break;
+						}
+					}
+				return root;
+				}
+
+		private:
+			//Prototypes with every hole replaced by a placeholder identifier. Shared so that events' ranges stay valid when the template is moved or copied.
+			std::shared_ptr<const string_t> source;
+			//Decoded literal string parameters, shared for the same reason.
+			std::shared_ptr<const string_arena<char_t>> strings;
+			std::vector<event> events;
+			//One symbol per event, none for events that have no literal name or identifier.
+			per_symbol_table<std::vector<symbol_t>> events_symbols;
+			std::vector<size_t> raw_holes_parameters_indices;
+			bool is_compiled{false};
+
+			void compile(view_t before_body_prototype, const std::vector<hole>& before_body_holes, view_t after_body_prototype, const std::vector<hole>& after_body_holes);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "replacement_template.cpp"
+#endif
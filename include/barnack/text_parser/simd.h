@@ -0,0 +1,221 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__AVX2__)
+	#define BARNACK_TEXT_PARSER_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define BARNACK_TEXT_PARSER_SIMD_SSE2
+#endif
+
+#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2) || defined(BARNACK_TEXT_PARSER_SIMD_SSE2)
+	#include <immintrin.h>
+#endif
+
+namespace barnack::text_parser::simd
+	{
+	using mask_t = uint32_t;
+
+	//Fixed amount of code units examined at once. Every bit of a mask corresponds to one code unit of the block, regardless of the code unit size.
+	#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2)
+		inline constexpr size_t block_size{32};
+	#else
+		inline constexpr size_t block_size{16};
+	#endif
+
+	inline size_t highest_bit(mask_t mask) noexcept { return static_cast<size_t>(std::bit_width(mask)) - 1; }
+
+	//Calls callback(index) for the index of every set bit of the mask, from the lowest to the highest.
+	inline void for_each_bit(mask_t mask, auto&& callback)
+		{
+		while (mask)
+			{
+			callback(static_cast<size_t>(std::countr_zero(mask)));
+			mask &= mask - 1;
+			}
+		}
+
+	template <typename CHAR_T>
+		requires(sizeof(CHAR_T) == 1 || sizeof(CHAR_T) == 2)
+	class block
+		{
+		public:
+			using char_t = CHAR_T;
+
+			//Reads exactly block_size code units.
+			block(const char_t* data) noexcept { load(data); }
+
+			//Reads count code units (count < block_size), the remaining ones are considered to be 0.
+			block(const char_t* data, size_t count) noexcept
+				{
+				std::array<char_t, block_size> padded{};
+				std::memcpy(padded.data(), data, count * sizeof(char_t));
+				load(padded.data());
+				}
+
+			mask_t equal(char_t value) const noexcept
+				{
+				#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2)
+					if constexpr (sizeof(char_t) == 1)
+						{
+						return static_cast<mask_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(registers[0], _mm256_set1_epi8(static_cast<char>(value)))));
+						}
+					else
+						{
+						const __m256i value_register{_mm256_set1_epi16(static_cast<short>(value))};
+						return pack(_mm256_cmpeq_epi16(registers[0], value_register), _mm256_cmpeq_epi16(registers[1], value_register));
+						}
+				#elif defined(BARNACK_TEXT_PARSER_SIMD_SSE2)
+					if constexpr (sizeof(char_t) == 1)
+						{
+						return static_cast<mask_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(registers[0], _mm_set1_epi8(static_cast<char>(value)))));
+						}
+					else
+						{
+						const __m128i value_register{_mm_set1_epi16(static_cast<short>(value))};
+						return pack(_mm_cmpeq_epi16(registers[0], value_register), _mm_cmpeq_epi16(registers[1], value_register));
+						}
+				#else
+					mask_t ret{0};
+					for (size_t i{0}; i < block_size; i++)
+						{
+						ret |= static_cast<mask_t>(units[i] == value) << i;
+						}
+					return ret;
+				#endif
+				}
+
+			//Code units outside of the ASCII range. For UTF-8 these are all the bytes belonging to multi-byte sequences.
+			mask_t non_ascii() const noexcept
+				{
+				#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2)
+					if constexpr (sizeof(char_t) == 1)
+						{
+						return static_cast<mask_t>(_mm256_movemask_epi8(registers[0]));
+						}
+					else
+						{
+						const __m256i high_bits{_mm256_set1_epi16(static_cast<short>(0xFF80))};
+						const __m256i zero{_mm256_setzero_si256()};
+						return ~pack(_mm256_cmpeq_epi16(_mm256_and_si256(registers[0], high_bits), zero), _mm256_cmpeq_epi16(_mm256_and_si256(registers[1], high_bits), zero));
+						}
+				#elif defined(BARNACK_TEXT_PARSER_SIMD_SSE2)
+					if constexpr (sizeof(char_t) == 1)
+						{
+						return static_cast<mask_t>(_mm_movemask_epi8(registers[0]));
+						}
+					else
+						{
+						const __m128i high_bits{_mm_set1_epi16(static_cast<short>(0xFF80))};
+						const __m128i zero{_mm_setzero_si128()};
+						return ~pack(_mm_cmpeq_epi16(_mm_and_si128(registers[0], high_bits), zero), _mm_cmpeq_epi16(_mm_and_si128(registers[1], high_bits), zero)) & 0xFFFF;
+						}
+				#else
+					mask_t ret{0};
+					for (size_t i{0}; i < block_size; i++)
+						{
+						ret |= static_cast<mask_t>(static_cast<std::make_unsigned_t<char_t>>(units[i]) >= 0x80) << i;
+						}
+					return ret;
+				#endif
+				}
+
+		private:
+			#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2)
+				//Plain array, the vector types' attributes would be ignored as std::array arguments.
+				__m256i registers[sizeof(char_t)];
+
+				void load(const char_t* data) noexcept
+					{
+					for (size_t i{0}; i < sizeof(char_t); i++)
+						{
+						registers[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data) + i);
+						}
+					}
+
+				//Compresses two 16 bits comparison results into one bit per code unit. packs works per 128 bits lane, the permutation restores the original order.
+				static mask_t pack(__m256i first, __m256i second) noexcept
+					{
+					return static_cast<mask_t>(_mm256_movemask_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(first, second), 0b11'01'10'00)));
+					}
+			#elif defined(BARNACK_TEXT_PARSER_SIMD_SSE2)
+				__m128i registers[sizeof(char_t)];
+
+				void load(const char_t* data) noexcept
+					{
+					for (size_t i{0}; i < sizeof(char_t); i++)
+						{
+						registers[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+						}
+					}
+
+				static mask_t pack(__m128i first, __m128i second) noexcept
+					{
+					return static_cast<mask_t>(_mm_movemask_epi8(_mm_packs_epi16(first, second)));
+					}
+			#else
+				std::array<char_t, block_size> units;
+
+				void load(const char_t* data) noexcept { std::copy_n(data, block_size, units.begin()); }
+			#endif
+		};
+
+	//Zero-extends block_size bytes to 16 bits code units.
+	inline void widen(const uint8_t* source, char16_t* destination) noexcept
+		{
+		#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2)
+			for (size_t i{0}; i < block_size; i += 16)
+				{
+				const __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))};
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_cvtepu8_epi16(bytes));
+				}
+		#elif defined(BARNACK_TEXT_PARSER_SIMD_SSE2)
+			const __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))};
+			const __m128i zero {_mm_setzero_si128()};
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination    ), _mm_unpacklo_epi8(bytes, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 8), _mm_unpackhi_epi8(bytes, zero));
+		#else
+			std::copy_n(source, block_size, destination);
+		#endif
+		}
+
+	//Truncates block_size 16 bits code units to bytes. Every unit must be below 0x100.
+	inline void narrow(const char16_t* source, uint8_t* destination) noexcept
+		{
+		#if defined(BARNACK_TEXT_PARSER_SIMD_AVX2)
+			const __m256i first {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source     ))};
+			const __m256i second{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 16))};
+			//packus works per 128 bits lane, the permutation restores the original order.
+			const __m256i packed{_mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0b11'01'10'00)};
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), packed);
+		#elif defined(BARNACK_TEXT_PARSER_SIMD_SSE2)
+			const __m128i first {_mm_loadu_si128(reinterpret_cast<const __m128i*>(source    ))};
+			const __m128i second{_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 8))};
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(first, second));
+		#else
+			for (size_t i{0}; i < block_size; i++) { destination[i] = static_cast<uint8_t>(source[i]); }
+		#endif
+		}
+
+	//Calls callback(block, index_of_the_first_unit_of_the_block) for every block of the range, the last one being zero-padded if incomplete.
+	//Stops early if the callback returns true.
+	template <typename char_t>
+	void for_each_block(const char_t* begin, const char_t* end, auto&& callback)
+		{
+		const size_t size{static_cast<size_t>(end - begin)};
+		size_t i{0};
+		for (; i + block_size <= size; i += block_size)
+			{
+			if (callback(block<char_t>{begin + i}, i)) { return; }
+			}
+		if (i < size)
+			{
+			callback(block<char_t>{begin + i, size - i}, i);
+			}
+		}
+	}
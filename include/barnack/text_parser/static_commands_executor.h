@@ -0,0 +1,244 @@
+#pragma once
+
+#include <bit>
+#include <array>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <algorithm>
+#include <typeinfo>
+#include <stdexcept>
+#include <type_traits>
+
+#include <utils/string.h>
+
+#include "tree_parser.h"
+#include "flat_tree.h"
+#include "commands_executor.h"
+#include "execution_context.h"
+
+namespace barnack::text_parser
+	{
+	//Executor for a set of definitions known at compile time.
+	//Hooks are called through the definitions' concrete types with qualified calls, so they aren't dispatched virtually and can be inlined.
+	//Names are resolved through a collision-free hash table built once on construction.
+	//Each definition must be passed as an object of exactly its template type, anything derived from it would have its overrides ignored.
+	template <typename CHAR_T, std::derived_from<command_definition::base<CHAR_T>>... DEFINITIONS>
+	class static_commands_executor
+		{
+		public:
+			using char_t         = CHAR_T;
+			using view_t         = std::basic_string_view<char_t>;
+			using string_t       = std::basic_string     <char_t>;
+			using input_command_t      = typename tree_parser<char_t>::command;
+			using input_command_view_t = typename flat_tree<char_t>::command_view;
+
+			static constexpr size_t definitions_count{sizeof...(DEFINITIONS)};
+
+			static_commands_executor(DEFINITIONS&... definitions) : definitions{definitions...}
+				{
+				const bool exact_types{(... && (typeid(definitions) == typeid(DEFINITIONS)))};
+				if (!exact_types)
+					{
+					throw std::logic_error{"Error creating static_commands_executor.\n"
+						"Every definition must be an object of exactly the type it is passed as."};
+					}
+
+				names = {utils::string::cast<char_t>(definitions.name())...};
+				build_table();
+				}
+
+			void execute(const input_command_t& input_command, execution_context<char_t>& context)
+				{
+				visit_definition(find_definition_index(input_command.name), [&](auto& definition) { execute(definition, input_command, context); });
+				}
+
+			void execute(const input_command_view_t& input_command, execution_context<char_t>& context)
+				{
+				visit_definition(find_definition_index(input_command.name), [&](auto& definition) { execute(definition, input_command, context); });
+				}
+
+			//Without outputs nor commands_executor, for definitions that only have side effects.
+			void execute(const input_command_t& input_command)
+				{
+				execution_context<char_t> context;
+				execute(input_command, context);
+				}
+			void execute(const input_command_view_t& input_command)
+				{
+				execution_context<char_t> context;
+				execute(input_command, context);
+				}
+
+		private:
+			std::tuple<DEFINITIONS&...> definitions;
+			std::array<string_t, definitions_count> names;
+
+			static constexpr size_t empty_slot{definitions_count};
+			//At least twice the definitions count, so a seed without collisions is found after a few tries.
+			std::vector<size_t> slots;
+			uint32_t seed{0};
+
+			static uint32_t hash(view_t name, uint32_t seed) noexcept
+				{
+				//FNV-1a over whole code units.
+				uint32_t ret{2166136261u ^ seed};
+				for (const char_t code_unit : name)
+					{
+					ret ^= static_cast<uint32_t>(static_cast<std::make_unsigned_t<char_t>>(code_unit));
+					ret *= 16777619u;
+					}
+				return ret;
+				}
+
+			size_t slot_of(view_t name) const noexcept { return hash(name, seed) & (slots.size() - 1); }
+
+			void build_table()
+				{
+				for (size_t i{0}; i < definitions_count; i++)
+					{
+					for (size_t j{i + 1}; j < definitions_count; j++)
+						{
+						if (names[i] == names[j])
+							{
+							throw std::logic_error{"Error creating static_commands_executor.\n"
+								"Command \"" + utils::string::cast<char>(names[i]) + "\" is defined more than once."};
+							}
+						}
+					}
+
+				size_t slots_count{std::bit_ceil(std::max<size_t>(definitions_count * 2, 1))};
+				while (true)
+					{
+					slots.assign(slots_count, empty_slot);
+					for (seed = 0; seed < 1024; seed++)
+						{
+						if (try_seed()) { return; }
+						std::ranges::fill(slots, empty_slot);
+						}
+					slots_count *= 2;
+					}
+				}
+
+			bool try_seed() noexcept
+				{
+				for (size_t i{0}; i < definitions_count; i++)
+					{
+					size_t& slot{slots[slot_of(names[i])]};
+					if (slot != empty_slot) { return false; }
+					slot = i;
+					}
+				return true;
+				}
+
+			//Name is a tokeniser range or a flat_tree range view.
+			size_t find_definition_index(const auto& input_command_name) const
+				{
+				const view_t name{input_command_name.string()};
+				const size_t index{slots[slot_of(name)]};
+				if (index == empty_slot || names[index] != name)
+					{
+					throw std::runtime_error{"Error resolving command \"" + utils::string::cast<char>(name) + "\"\n"
+						"Command not found.\n"
+						"Command at: " + input_command_name.begin.to_string()};
+					}
+				return index;
+				}
+
+			void visit_definition(size_t index, auto&& callback)
+				{
+				visit_definition(index, callback, std::index_sequence_for<DEFINITIONS...>{});
+				}
+			template <size_t... indices>
+			void visit_definition(size_t index, auto& callback, std::index_sequence<indices...>)
+				{
+				(void)(... || (index == indices && (callback(std::get<indices>(definitions)), true)));
+				}
+
+			//Hooks are called on the concrete type when it declares the overload, a derived definition may hide some of base's overloads by declaring the other ones.
+			//Those hidden overloads are reached through the virtual call instead.
+			template <typename definition_t>
+			static void validate(const definition_t& definition, const auto& command, const execution_context<char_t>& context)
+				{
+				if constexpr (requires { definition.definition_t::validate(command, context); }) { definition.definition_t::validate(command, context); }
+				else { static_cast<const command_definition::base<char_t>&>(definition).validate(command, context); }
+				}
+			template <typename definition_t>
+			static void on_begin(definition_t& definition, const auto& command, execution_context<char_t>& context)
+				{
+				if constexpr (requires { definition.definition_t::on_begin(command, context); }) { definition.definition_t::on_begin(command, context); }
+				else { static_cast<command_definition::base<char_t>&>(definition).on_begin(command, context); }
+				}
+			template <typename definition_t>
+			static void on_end(definition_t& definition, const auto& command, execution_context<char_t>& context)
+				{
+				if constexpr (requires { definition.definition_t::on_end(command, context); }) { definition.definition_t::on_end(command, context); }
+				else { static_cast<command_definition::base<char_t>&>(definition).on_end(command, context); }
+				}
+			template <typename definition_t>
+			static void on_child(definition_t& definition, const auto& command, const auto& child, execution_context<char_t>& context)
+				{
+				if constexpr (requires { definition.definition_t::on_child(command, child, context); }) { definition.definition_t::on_child(command, child, context); }
+				else { static_cast<command_definition::base<char_t>&>(definition).on_child(command, child, context); }
+				}
+
+			template <typename definition_t>
+			void execute(definition_t& definition, const input_command_t& input_command, execution_context<char_t>& context)
+				{
+				validate(definition, input_command, context);
+
+				on_begin(definition, input_command, context);
+
+				tree_parser<char_t>::for_each_element(input_command.children, [&](const typename tree_parser<char_t>::sequence_element& child)
+					{
+					if (const auto child_command_ptr{std::get_if<input_command_t>(&child)})
+						{
+						const input_command_t& child_command{*child_command_ptr};
+						on_child(definition, input_command, child_command, context);
+
+						if (definition.definition_t::execute_child_commands())
+							{
+							execute(child_command, context);
+							}
+						}
+					else
+						{
+						on_child(definition, input_command, std::get<typename tokeniser<char_t>::range>(child), context);
+						}
+					});
+
+				on_end(definition, input_command, context);
+				}
+
+			template <typename definition_t>
+			void execute(definition_t& definition, const input_command_view_t& input_command, execution_context<char_t>& context)
+				{
+				validate(definition, input_command, context);
+
+				on_begin(definition, input_command, context);
+
+				for (const auto& child : input_command.children)
+					{
+					if (child.is_command())
+						{
+						const input_command_view_t child_command{child.command()};
+						on_child(definition, input_command, child_command, context);
+
+						if (definition.definition_t::execute_child_commands())
+							{
+							execute(child_command, context);
+							}
+						}
+					else
+						{
+						on_child(definition, input_command, child.range(), context);
+						}
+					}
+
+				on_end(definition, input_command, context);
+				}
+		};
+	}
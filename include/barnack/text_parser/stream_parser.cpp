@@ -0,0 +1,171 @@
+#include "stream_parser.h"
+
+#include <algorithm>
+
+#include "character_classes.h"
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	typename stream_parser<char_t>::chunk stream_parser<char_t>::feed(view_t input)
+		{
+		pending += input;
+		scan();
+
+		size_t end{safe_end};
+		if (depth == 0 && header == header_part::none)
+			{
+			//Trailing top level raw text can be handed out already, except for a codepoint that isn't complete yet.
+			end = std::max(end, pending.size() - incomplete_codepoint_tail());
+			}
+		return extract(end);
+		}
+
+	template <typename char_t>
+	typename stream_parser<char_t>::chunk stream_parser<char_t>::finish()
+		{
+		chunk ret{extract(pending.size())};
+		reset();
+		return ret;
+		}
+
+	template <typename char_t>
+	void stream_parser<char_t>::reset() noexcept
+		{
+		pending.clear();
+		pending_origin = {};
+		scanned  = 0;
+		safe_end = 0;
+		depth    = 0;
+		header   = header_part::none;
+		in_string = previous_is_backslash = false;
+		}
+
+	template <typename char_t>
+	void stream_parser<char_t>::scan()
+		{
+		//Only ASCII code units are structural, and they never appear inside multi-unit sequences, so scanning doesn't need to decode.
+		for (; scanned < pending.size(); scanned++)
+			{
+			const char_t unit{pending[scanned]};
+			if (in_string)
+				{
+				if (unit == static_cast<char_t>('\"') && !previous_is_backslash) { in_string = false; }
+				//An escaped backslash doesn't escape what follows it.
+				previous_is_backslash = (unit == static_cast<char_t>('\\')) && !previous_is_backslash;
+				}
+			else if (header != header_part::none)
+				{
+				const bool terminates{header != header_part::parameters && (unit == static_cast<char_t>('{') || unit == static_cast<char_t>(';'))};
+				bool malformed{false};
+				if (terminates)
+					{
+					header = header_part::none;
+					if (unit == static_cast<char_t>('{')) { depth++; }
+					else if (depth == 0) { safe_end = scanned + 1; }
+					}
+				else if (header == header_part::name)
+					{
+					//Non ASCII units may be part of xid identifiers, the parser decides.
+					const bool is_name_unit{static_cast<uint32_t>(unit) >= 0x80 || (character_classes::latin1[static_cast<uint32_t>(unit)] & character_classes::identifier_continue)};
+					if (unit == static_cast<char_t>('(')) { header = header_part::parameters; }
+					else { malformed = !is_name_unit; }
+					}
+				else if (header == header_part::parameters)
+					{
+					if (unit == static_cast<char_t>('\"'))
+						{
+						in_string = true;
+						previous_is_backslash = false;
+						}
+					else if (unit == static_cast<char_t>(')')) { header = header_part::after_parameters; }
+					else
+						{
+						malformed = unit == static_cast<char_t>('\\') || unit == static_cast<char_t>('{') || unit == static_cast<char_t>('}') || unit == static_cast<char_t>(';');
+						}
+					}
+				else { malformed = true; }
+
+				if (malformed)
+					{
+					//Rather than buffering until a terminator that may never come, everything up to here is parsed so the parser reports the error.
+					header = header_part::none;
+					safe_end = scanned + 1;
+					}
+				}
+			else if (unit == static_cast<char_t>('\\'))
+				{
+				if (depth == 0) { safe_end = scanned; }
+				header = header_part::name;
+				}
+			else if (unit == static_cast<char_t>('}'))
+				{
+				//An unmatched closing bracket is left for the parser to report.
+				if (depth > 0) { depth--; }
+				if (depth == 0) { safe_end = scanned + 1; }
+				}
+			}
+		}
+
+	template <typename char_t>
+	size_t stream_parser<char_t>::incomplete_codepoint_tail() const noexcept
+		{
+		if constexpr (sizeof(char_t) == 2)
+			{
+			const bool ends_with_high_surrogate{!pending.empty() && pending.back() >= 0xD800 && pending.back() <= 0xDBFF};
+			return ends_with_high_surrogate ? 1 : 0;
+			}
+		else
+			{
+			for (size_t tail{1}; tail <= std::min<size_t>(4, pending.size()); tail++)
+				{
+				const auto unit{static_cast<unsigned char>(pending[pending.size() - tail])};
+				if ((unit & 0b1100'0000) == 0b1000'0000) { continue; } //continuation byte
+
+				const size_t sequence_length
+					{
+					(unit & 0b1000'0000) == 0           ? size_t{1} :
+					(unit & 0b1110'0000) == 0b1100'0000 ? size_t{2} :
+					(unit & 0b1111'0000) == 0b1110'0000 ? size_t{3} : size_t{4}
+					};
+				return sequence_length > tail ? tail : 0;
+				}
+			return 0;
+			}
+		}
+
+	template <typename char_t>
+	typename stream_parser<char_t>::chunk stream_parser<char_t>::extract(size_t end)
+		{
+		chunk ret;
+		if (end == 0) { return ret; }
+
+		auto source{std::make_shared<string_t>(pending, 0, end)};
+		pending.erase(0, end);
+		scanned  -= std::min(scanned , end);
+		safe_end -= std::min(safe_end, end);
+
+		tokeniser_t tokeniser{*source, pending_origin};
+		pending_origin = tokeniser.next_to(tokeniser.begin_with_info(), tokeniser.end()).end;
+		pending_origin.it = nullptr;
+
+		tree_parser<char_t> parser;
+		parser.symbol_table_ptr = symbol_table_ptr;
+		//The document can't be continued past an error, the parser is left ready for another one.
+		try { parser.parse_all(tokeniser); }
+		catch (...)
+			{
+			reset();
+			throw;
+			}
+
+		ret.source   = std::move(source);
+		ret.elements = std::move(parser.root.children);
+		ret.strings  = std::move(parser.strings);
+		return ret;
+		}
+
+	template class stream_parser<char16_t>;
+	template class stream_parser<char8_t>;
+	template class stream_parser<char>;
+	}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "tokeniser.h"
+#include "tree_parser.h"
+
+namespace barnack::text_parser
+	{
+	//Push parser for documents that arrive in pieces, or that don't fit in memory as a whole.
+	//Input is buffered only until the top level elements it contains are complete; those are then parsed and handed out, and their text released from the buffer.
+	//Memory usage is bounded by the size of the biggest top level command rather than by the size of the document.
+	//Top level raw text is handed out as soon as it's available, so it can be split in more ranges than parse_all would produce.
+	template <typename CHAR_T>
+	class stream_parser
+		{
+		public:
+			using char_t      = CHAR_T;
+			using view_t      = std::basic_string_view<char_t>;
+			using string_t    = std::basic_string     <char_t>;
+			using tokeniser_t = tokeniser<char_t>;
+
+			struct chunk
+				{
+				//Owns the text all the ranges in elements refer to.
+				std::shared_ptr<const string_t> source;
+				//Owns the decoded string parameters that don't refer to source.
+				string_arena<char_t> strings;
+				typename tree_parser<char_t>::sequence elements;
+				};
+
+			//Commands, parameters, strings and multi-unit codepoints can straddle the boundary between consecutive inputs.
+			chunk feed(view_t input);
+			//Parses whatever is left, as parse_all would at the end of a document, and leaves the parser ready for another document.
+			chunk finish();
+
+			//Forwarded to the parsers, see parser_base::symbol_table_ptr.
+			utils::observer_ptr<const symbol_table> symbol_table_ptr{nullptr};
+
+		private:
+			string_t pending;
+			//Global position of the first code unit of pending.
+			typename tokeniser_t::iterator_with_info pending_origin;
+
+			//Part of the command header being scanned, a header that can't continue as a valid one is handed to the parser right away.
+			enum class header_part : uint8_t { none, name, parameters, after_parameters };
+
+			//Scanner state, persistent across calls so already seen input is never scanned twice.
+			size_t scanned{0};
+			size_t safe_end{0};
+			size_t depth{0};
+			header_part header{header_part::none};
+			bool in_string{false};
+			bool previous_is_backslash{false};
+
+			void reset() noexcept;
+			void scan();
+			size_t incomplete_codepoint_tail() const noexcept;
+			chunk extract(size_t end);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "stream_parser.cpp"
+#endif
@@ -0,0 +1,48 @@
+#include "string_arena.h"
+
+#include <algorithm>
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	char_t* string_arena<char_t>::allocate(size_t size)
+		{
+		if (chunks.empty() || chunks.back().capacity() - chunks.back().size() < size)
+			{
+			chunks.emplace_back().reserve(std::max(chunk_capacity, size));
+			}
+		auto& chunk{chunks.back()};
+		const size_t begin{chunk.size()};
+		chunk.resize(begin + size);
+		total_size += size;
+		return chunk.data() + begin;
+		}
+
+	template <typename char_t>
+	void string_arena<char_t>::shrink_last(size_t count) noexcept
+		{
+		auto& chunk{chunks.back()};
+		chunk.resize(chunk.size() - count);
+		total_size -= count;
+		}
+
+	template <typename char_t>
+	void string_arena<char_t>::splice(string_arena&& other) noexcept
+		{
+		//Other's chunks go first so that this arena's last chunk, the one still being filled, stays last.
+		chunks.splice(chunks.begin(), other.chunks);
+		total_size += other.total_size;
+		other.total_size = 0;
+		}
+
+	template <typename char_t>
+	void string_arena<char_t>::clear() noexcept
+		{
+		chunks.clear();
+		total_size = 0;
+		}
+
+	template class string_arena<char16_t>;
+	template class string_arena<char8_t>;
+	template class string_arena<char>;
+	}
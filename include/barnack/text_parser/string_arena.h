@@ -0,0 +1,44 @@
+#pragma once
+
+#include <list>
+#include <string>
+
+namespace barnack::text_parser
+	{
+	//Storage for strings that are referred to by views, like decoded string parameters. What it hands out stays valid, and in place,
+	//until the arena is cleared or destroyed; moving the arena or splicing it into another one doesn't move the strings.
+	template <typename CHAR_T>
+	class string_arena
+		{
+		public:
+			using char_t   = CHAR_T;
+			using view_t   = std::basic_string_view<char_t>;
+			using string_t = std::basic_string     <char_t>;
+
+			string_arena(size_t chunk_capacity = 4 * 1024) noexcept : chunk_capacity{chunk_capacity > 0 ? chunk_capacity : 1} {}
+			string_arena(const string_arena& copy) = delete;
+			string_arena& operator=(const string_arena& copy) = delete;
+			string_arena(string_arena&& move) noexcept = default;
+			string_arena& operator=(string_arena&& move) noexcept = default;
+
+			//Room for size code units, contiguous.
+			char_t* allocate(size_t size);
+			//Gives the last count code units of the latest allocation back, for callers that allocate for the worst case.
+			void shrink_last(size_t count) noexcept;
+			//Takes over the other arena's strings, views into them stay valid.
+			void splice(string_arena&& other) noexcept;
+			void clear() noexcept;
+			//Code units handed out.
+			size_t size() const noexcept { return total_size; }
+
+		private:
+			size_t chunk_capacity;
+			size_t total_size{0};
+			//Chunks are reserved once and never grow past their capacity. List nodes don't move.
+			std::list<string_t> chunks;
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "string_arena.cpp"
+#endif
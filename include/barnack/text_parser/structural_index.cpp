@@ -0,0 +1,107 @@
+#include "structural_index.h"
+
+#include <limits>
+#include <algorithm>
+
+#include "simd.h"
+
+namespace barnack::text_parser
+	{
+	template <typename char_t>
+	structural_index<char_t>::structural_index(view_t string) : string_size{string.size()}
+		{
+		simd::for_each_block(string.data(), string.data() + string.size(), [this](const simd::block<char_t>& block, size_t block_begin)
+			{
+			const simd::mask_t mask
+				{
+				block.equal(static_cast<char_t>('\\')) | block.equal(static_cast<char_t>('{')) | block.equal(static_cast<char_t>('}')) |
+				block.equal(static_cast<char_t>('(' )) | block.equal(static_cast<char_t>(')')) | block.equal(static_cast<char_t>(';')) |
+				block.equal(static_cast<char_t>(',' )) | block.equal(static_cast<char_t>('\"'))
+				};
+			simd::for_each_bit(mask, [&](size_t index) { positions.push_back(block_begin + index); });
+			return false;
+			});
+		}
+
+	template <typename char_t>
+	typename structural_index<char_t>::split_points structural_index<char_t>::top_level_split_points(view_t string, size_t parts_count) const
+		{
+		split_points ret;
+
+		size_t next_part{1};
+		const auto add_split{[&](size_t position)
+			{
+			if (next_part >= parts_count || position >= string.size()) { return; }
+			if (position < string.size() * next_part / parts_count) { return; }
+			if (position <= (ret.positions.empty() ? 0 : ret.positions.back())) { return; }
+
+			ret.positions.push_back(position);
+			while (next_part < parts_count && string.size() * next_part / parts_count <= position) { next_part++; }
+			}};
+
+		//Same rules as the parser, only looking at structural characters.
+		size_t depth{0};
+		bool in_header{false};
+		bool in_string{false};
+		//Backslashes are structural too, so escapes are seen in order: a backslash escapes the unit right after it unless it's escaped itself.
+		size_t escaping_backslash_position{std::numeric_limits<size_t>::max()};
+		for (const size_t position : positions)
+			{
+			const char_t unit{string[position]};
+			if (in_string)
+				{
+				const bool escaped{escaping_backslash_position != std::numeric_limits<size_t>::max() && escaping_backslash_position + 1 == position};
+				if (unit == static_cast<char_t>('\"') && !escaped) { in_string = false; }
+				escaping_backslash_position = (unit == static_cast<char_t>('\\') && !escaped) ? position : std::numeric_limits<size_t>::max();
+				}
+			else if (in_header)
+				{
+				if (unit == static_cast<char_t>('\"'))
+					{
+					in_string = true;
+					}
+				else if (unit == static_cast<char_t>('{'))
+					{
+					in_header = false;
+					depth++;
+					}
+				else if (unit == static_cast<char_t>(';'))
+					{
+					in_header = false;
+					if (depth == 0) { add_split(position + 1); }
+					}
+				}
+			else if (unit == static_cast<char_t>('\\'))
+				{
+				if (depth == 0) { add_split(position); }
+				in_header = true;
+				}
+			else if (unit == static_cast<char_t>('}'))
+				{
+				//An unmatched closing bracket is left for the parser to report.
+				if (depth > 0) { depth--; }
+				if (depth == 0) { add_split(position + 1); }
+				}
+			}
+
+		ret.complete = depth == 0 && !in_header;
+		return ret;
+		}
+
+	template <typename char_t>
+	structural_index<char_t> structural_index<char_t>::slice(size_t begin, size_t end) const
+		{
+		structural_index ret;
+		ret.string_size = end - begin;
+
+		const auto first{std::ranges::lower_bound(positions, begin)};
+		const auto last {std::lower_bound(first, positions.end(), end)};
+		ret.positions.reserve(static_cast<size_t>(last - first));
+		std::transform(first, last, std::back_inserter(ret.positions), [begin](size_t position) { return position - begin; });
+		return ret;
+		}
+
+	template struct structural_index<char16_t>;
+	template struct structural_index<char8_t>;
+	template struct structural_index<char>;
+	}
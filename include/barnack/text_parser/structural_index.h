@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "tokeniser.h"
+
+namespace barnack::text_parser
+	{
+	//First stage of a two stages parse: finds all the characters that can alter the structure of the tree in a single vectorized pass.
+	//The tree_parser can then jump between those positions instead of decoding every codepoint of raw text.
+	//Structural characters are all ASCII, and ASCII code units never appear inside multi-unit UTF-8 or UTF-16 sequences, so no decoding is needed to find them.
+	template <typename CHAR_T>
+	struct structural_index
+		{
+		using char_t = CHAR_T;
+		using view_t = std::basic_string_view<char_t>;
+
+		static constexpr bool is_structural(char32_t codepoint) noexcept
+			{
+			return codepoint == U'\\' || codepoint == U'{' || codepoint == U'}' || codepoint == U'(' || codepoint == U')' || codepoint == U';' || codepoint == U',' || codepoint == U'\"';
+			}
+
+		structural_index() = default;
+		structural_index(view_t string);
+
+		//Positions in code units from the beginning of the indexed string, in increasing order.
+		std::vector<size_t> positions;
+		//Size of the indexed string, used to check that the index is used with the tokeniser it was built for.
+		size_t string_size{0};
+
+		struct split_points
+			{
+			std::vector<size_t> positions;
+			//False if the string ends inside a body or a command header.
+			bool complete{true};
+			};
+
+		//Positions at brace depth 0 outside of command headers, where the string can be split into parts that parse exactly as they would within the whole string.
+		//Returns at most parts_count - 1 positions, the first ones at or after evenly spaced targets.
+		split_points top_level_split_points(view_t string, size_t parts_count) const;
+
+		//Index of the [begin, end) part of the indexed string, with positions relative to begin.
+		structural_index slice(size_t begin, size_t end) const;
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "structural_index.cpp"
+#endif
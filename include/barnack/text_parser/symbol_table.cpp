@@ -0,0 +1,36 @@
+#include "symbol_table.h"
+
+#include <stdexcept>
+
+namespace barnack::text_parser
+	{
+	symbol_table::symbol_t symbol_table::intern(std::string_view name)
+		{
+		if (const auto it{symbols.find(name)}; it != symbols.end())
+			{
+			return it->second;
+			}
+		if (names.size() >= none)
+			{
+			throw std::length_error{"Too many symbols."};
+			}
+
+		const symbol_t symbol{static_cast<symbol_t>(names.size())};
+		const std::string& stored_name{names.emplace_back(name)};
+		symbols.emplace(std::string_view{stored_name}, symbol);
+		return symbol;
+		}
+
+	symbol_table::symbol_t symbol_table::find(std::string_view name) const noexcept
+		{
+		const auto it{symbols.find(name)};
+		return it == symbols.end() ? none : it->second;
+		}
+
+	std::string_view symbol_table::name(symbol_t symbol) const noexcept
+		{
+		return symbol < names.size() ? std::string_view{names[symbol]} : std::string_view{};
+		}
+
+	size_t symbol_table::size() const noexcept { return names.size(); }
+	}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <string_view>
+#include <unordered_map>
+
+#include <utils/memory.h>
+
+namespace barnack::text_parser
+	{
+	//Dense integer ids for identifiers. Command names and identifiers definitions care about are interned once when definitions are registered,
+	//parsers then only look identifiers up, so the table never grows while parsing and comparing identifiers is comparing integers.
+	class symbol_table
+		{
+		public:
+			using symbol_t = uint32_t;
+			static constexpr symbol_t none{std::numeric_limits<symbol_t>::max()};
+
+			symbol_t intern(std::string_view name);
+
+			//Doesn't allocate for identifiers up to lookup_buffer_size code units.
+			template <typename char_t>
+			symbol_t find(std::basic_string_view<char_t> name) const
+				{
+				if constexpr (sizeof(char_t) == 1)
+					{
+					return find(std::string_view{reinterpret_cast<const char*>(name.data()), name.size()});
+					}
+				else
+					{
+					//Identifiers only contain ASCII characters, anything else can't be a known symbol.
+					const auto narrow{[&name](char* out)
+						{
+						for (size_t i{0}; i < name.size(); i++)
+							{
+							if (name[i] > 0x7F) { return false; }
+							out[i] = static_cast<char>(name[i]);
+							}
+						return true;
+						}};
+
+					if (name.size() <= lookup_buffer_size)
+						{
+						std::array<char, lookup_buffer_size> buffer;
+						return narrow(buffer.data()) ? find(std::string_view{buffer.data(), name.size()}) : none;
+						}
+					std::string buffer(name.size(), '\0');
+					return narrow(buffer.data()) ? find(std::string_view{buffer}) : none;
+					}
+				}
+			symbol_t find(std::string_view name) const noexcept;
+
+			std::string_view name(symbol_t symbol) const noexcept;
+			size_t size() const noexcept;
+
+		private:
+			static constexpr size_t lookup_buffer_size{64};
+
+			//Deque so that names never move and the map can key on views of them.
+			std::deque<std::string> names;
+			std::unordered_map<std::string_view, symbol_t> symbols;
+		};
+
+	//Something a definition derives from the symbols of one table, like the symbols of the identifiers it accepts.
+	//A definition can be registered with several executors, each with its own table, so it keeps one value per table.
+	//Values are added when registering and only read when executing.
+	template <typename T>
+	class per_symbol_table
+		{
+		public:
+			//The value for table, default constructed the first time.
+			T& operator[](const symbol_table& table)
+				{
+				for (auto& entry : entries)
+					{
+					if (entry.first == std::addressof(table)) { return entry.second; }
+					}
+				return entries.emplace_back(std::addressof(table), T{}).second;
+				}
+
+			//Null if nothing was stored for table.
+			utils::observer_ptr<const T> find(const symbol_table& table) const noexcept
+				{
+				for (const auto& entry : entries)
+					{
+					if (entry.first == std::addressof(table)) { return std::addressof(entry.second); }
+					}
+				return nullptr;
+				}
+
+		private:
+			//Definitions are registered with few executors, a linear search beats hashing.
+			std::vector<std::pair<utils::observer_ptr<const symbol_table>, T>> entries;
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "symbol_table.cpp"
+#endif
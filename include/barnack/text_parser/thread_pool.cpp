@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+
+#include <utility>
+#include <algorithm>
+
+namespace barnack::text_parser
+	{
+	thread_pool::thread_pool(size_t threads_count)
+		{
+		threads_count = std::max<size_t>(threads_count, 1);
+		workers.reserve(threads_count - 1);
+		for (size_t i{1}; i < threads_count; i++) { workers.emplace_back([this, i]() { work(i); }); }
+		}
+
+	thread_pool::~thread_pool()
+		{
+			{
+			std::scoped_lock lock{mutex};
+			stopping = true;
+			}
+		wake.notify_all();
+		//jthreads join on destruction.
+		workers.clear();
+		}
+
+	size_t thread_pool::threads_count() const noexcept { return workers.size() + 1; }
+
+	void thread_pool::for_each_index(size_t count, const job_t& job)
+		{
+		if (count == 0) { return; }
+		std::scoped_lock batch_lock{batch_mutex};
+
+			{
+			std::scoped_lock lock{mutex};
+			job_ptr = std::addressof(job);
+			this->count = count;
+			next_index.store(0, std::memory_order_relaxed);
+			error = nullptr;
+			running_workers = workers.size();
+			generation++;
+			}
+		wake.notify_all();
+
+		run_batch(0);
+
+		std::unique_lock lock{mutex};
+		done.wait(lock, [this]() { return running_workers == 0; });
+		job_ptr = nullptr;
+		if (error) { std::rethrow_exception(std::exchange(error, nullptr)); }
+		}
+
+	void thread_pool::work(size_t worker_index)
+		{
+		size_t seen_generation{0};
+		while (true)
+			{
+				{
+				std::unique_lock lock{mutex};
+				wake.wait(lock, [&]() { return stopping || generation != seen_generation; });
+				if (stopping) { return; }
+				seen_generation = generation;
+				}
+
+			run_batch(worker_index);
+
+				{
+				std::scoped_lock lock{mutex};
+				running_workers--;
+				if (running_workers == 0) { done.notify_one(); }
+				}
+			}
+		}
+
+	void thread_pool::run_batch(size_t worker_index)
+		{
+		while (true)
+			{
+			const size_t index{next_index.fetch_add(1, std::memory_order_relaxed)};
+			if (index >= count) { return; }
+			try
+				{
+				(*job_ptr)(index, worker_index);
+				}
+			catch (...)
+				{
+				std::scoped_lock lock{mutex};
+				if (!error) { error = std::current_exception(); }
+				//Nobody claims the remaining indices.
+				next_index.store(count, std::memory_order_relaxed);
+				}
+			}
+		}
+	}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace barnack::text_parser
+	{
+	//Fixed set of threads kept alive across batches, so that processing many small batches doesn't pay for thread creation each time.
+	//Indices are claimed one at a time from a shared counter: a worker that is done with a cheap item immediately takes the next one, long items don't hold back the others.
+	class thread_pool
+		{
+		public:
+			//The calling thread takes part in every batch as worker 0, threads_count - 1 threads are created.
+			thread_pool(size_t threads_count = std::thread::hardware_concurrency());
+			~thread_pool();
+			thread_pool(const thread_pool&) = delete;
+			thread_pool& operator=(const thread_pool&) = delete;
+
+			size_t threads_count() const noexcept;
+
+			using job_t = std::function<void(size_t index, size_t worker_index)>;
+			//Calls job once for each index in [0, count) and returns when all calls are done. worker_index is in [0, threads_count()).
+			//If calls throw, the first exception is rethrown once the batch is over; indices not yet claimed at that point are skipped.
+			//Batches submitted from different threads run one after the other.
+			void for_each_index(size_t count, const job_t& job);
+
+		private:
+			std::vector<std::jthread> workers;
+
+			std::mutex batch_mutex;
+
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::condition_variable done;
+			size_t generation{0};
+			size_t running_workers{0};
+			bool stopping{false};
+
+			//Current batch, only valid while running_workers isn't 0.
+			const job_t* job_ptr{nullptr};
+			size_t count{0};
+			std::atomic<size_t> next_index{0};
+			std::exception_ptr error;
+
+			void work(size_t worker_index);
+			void run_batch(size_t worker_index);
+		};
+	}
+
+#ifdef IMPLEMENTATION
+#include "thread_pool.cpp"
+#endif
@@ -1,7 +1,16 @@
 #include "tokeniser.h"
 
+#include "simd.h"
+#include "transcode.h"
+
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <type_traits>
+
 #include <utils/third_party/utf8.h>
-#include <utils/third_party/unicodelib.h>
 
 namespace barnack::text_parser
 	{
@@ -27,7 +36,23 @@ namespace barnack::text_parser
 
 
 	template <typename char_t>
-	tokeniser<char_t>::tokeniser(view_t string) : string{string} {}
+	tokeniser<char_t>::tokeniser(view_t string, validation validation) : tokeniser{string, iterator_with_info{}, validation} {}
+
+	template <typename char_t>
+	tokeniser<char_t>::tokeniser(view_t string, const iterator_with_info& origin, validation validation) : string{string}, origin{origin}
+		{
+		if (validation == validation::upfront)
+			{
+			const size_t invalid_index{transcode::validate(string)};
+			if (invalid_index != transcode::valid)
+				{
+				throw std::runtime_error{"Error validating text.\n"
+					"Invalid " + std::string{sizeof(char_t) == 1 ? "UTF-8" : "UTF-16"} + " sequence.\n"
+					"At: " + next_to(begin_with_info(), begin() + invalid_index).end.to_string()};
+				}
+			}
+		validated = validation != validation::per_codepoint;
+		}
 
 
 	template <typename char_t>
@@ -40,7 +65,13 @@ namespace barnack::text_parser
 	template <typename char_t>
 	tokeniser<char_t>::iterator_with_info tokeniser<char_t>::begin_with_info() const noexcept
 		{
-		const iterator_with_info ret{.it{begin()}};
+		const iterator_with_info ret
+			{
+			.it              {begin()},
+			.position        {origin.position},
+			.line            {origin.line},
+			.position_in_line{origin.position_in_line}
+			};
 		return ret;
 		}
 
@@ -52,14 +83,22 @@ namespace barnack::text_parser
 		}
 
 	template <typename char_t>
-	typename tokeniser<char_t>::codepoint_with_raw_range tokeniser<char_t>::next_codepoint_raw(const typename tokeniser<char_t>::iterator& begin) const noexcept
+	typename tokeniser<char_t>::codepoint_with_raw_range tokeniser<char_t>::next_codepoint_raw(const typename tokeniser<char_t>::iterator& begin) const
 		{
+		//Unchecked decoding would read past the string, checked decoding would fail on an empty sequence.
+		if (begin == this->end())
+			{
+			throw std::runtime_error{"Unexpected end of input.\n"
+				"At: " + next_to(begin_with_info(), begin).end.to_string()};
+			}
+
 		iterator end{begin};
 
 		const iterator string_end_it{string.data() + string.size()};
 
 		const char32_t codepoint{[&]()
 			{
+			if (validated) { return static_cast<char32_t>(transcode::decode_unchecked(end)); }
 			if constexpr (std::same_as<char_t, char8_t> || std::same_as<char_t, char>)
 				{
 				return utf8::next(end, this->end());
@@ -78,7 +117,7 @@ namespace barnack::text_parser
 		}
 
 	template <typename char_t>
-	typename tokeniser<char_t>::codepoint_with_range tokeniser<char_t>::next_codepoint(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+	typename tokeniser<char_t>::codepoint_with_range tokeniser<char_t>::next_codepoint(const typename tokeniser<char_t>::iterator_with_info& begin) const
 		{
 		const codepoint_with_raw_range next_codepoint_ret{next_codepoint_raw(begin.it)};
 
@@ -109,103 +148,288 @@ namespace barnack::text_parser
 
 
 	template <typename char_t>
-	typename tokeniser<char_t>::range tokeniser<char_t>::next_whitespace(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+	typename tokeniser<char_t>::range tokeniser<char_t>::next_to(const typename tokeniser<char_t>::iterator_with_info& begin, const typename tokeniser<char_t>::iterator& end) const noexcept
 		{
-		return next_if(begin, [](const codepoint_with_range& cpwr)
+		size_t newlines_count{0};
+		size_t last_newline_index{0};
+		simd::for_each_block(begin.it, end, [&](const simd::block<char_t>& block, size_t block_begin)
 			{
-			const bool ret{unicode::is_white_space(cpwr.codepoint)};
-			return ret;
+			const simd::mask_t newlines{block.equal(static_cast<char_t>('\n'))};
+			if (newlines)
+				{
+				newlines_count += static_cast<size_t>(std::popcount(newlines));
+				last_newline_index = block_begin + simd::highest_bit(newlines);
+				}
+			return false;
 			});
+
+		const size_t position_delta{static_cast<size_t>(end - begin.it)};
+		const range ret
+			{
+			.begin{begin},
+			.end
+				{
+				.it              {end},
+				.position        {begin.position + position_delta},
+				.line            {begin.line + newlines_count},
+				.position_in_line{newlines_count ? (position_delta - last_newline_index - 1) : (begin.position_in_line + position_delta)}
+				}
+			};
+		return ret;
 		}
 
 	template <typename char_t>
-	typename tokeniser<char_t>::range tokeniser<char_t>::next_identifier(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+	typename tokeniser<char_t>::range tokeniser<char_t>::next_run(const typename tokeniser<char_t>::iterator_with_info& begin, character_classes::mask_t mask) const noexcept
 		{
-		const auto first{next_codepoint(begin)};
-		const bool first_valid
-			{
-			(first.codepoint >= U'a' && first.codepoint <= U'z') ||
-			(first.codepoint >= U'A' && first.codepoint <= U'z') ||
-			(first.codepoint == U'_')
-			};
-		if (!first_valid)
+		using unit_t = std::make_unsigned_t<char_t>;
+
+		iterator it{begin.it};
+		const iterator end{this->end()};
+		while (it != end)
 			{
-			return range{begin, begin};
+			//ASCII code units are classified directly, only the others are decoded.
+			while (it != end && static_cast<unit_t>(*it) < 0x80 && (character_classes::latin1[static_cast<unit_t>(*it)] & mask)) { ++it; }
+			if (it == end || static_cast<unit_t>(*it) < 0x80) { break; }
+
+			const codepoint_with_raw_range next_codepoint_ret{next_codepoint_raw(it)};
+			if (!(character_classes::of(next_codepoint_ret.codepoint) & mask)) { break; }
+			it = next_codepoint_ret.range.data() + next_codepoint_ret.range.size();
 			}
 
-		const range after_first{next_if(first.range.end, [](const codepoint_with_range& cpwr)
+		//Only whitespace runs can contain newlines.
+		if (mask & character_classes::whitespace) { return next_to(begin, it); }
+
+		const size_t position_delta{static_cast<size_t>(it - begin.it)};
+		const range ret
 			{
-			const bool ret
+			.begin{begin},
+			.end
 				{
-				(cpwr.codepoint >= U'a' && cpwr.codepoint <= U'z') ||
-				(cpwr.codepoint >= U'A' && cpwr.codepoint <= U'z') ||
-				(cpwr.codepoint >= U'0' && cpwr.codepoint <= U'9') ||
-				(cpwr.codepoint == U'_')
-				};
-			return ret;
-			})};
-
-		return range{begin, after_first.end};
+				.it              {it},
+				.position        {begin.position         + position_delta},
+				.line            {begin.line},
+				.position_in_line{begin.position_in_line + position_delta}
+				}
+			};
+		return ret;
 		}
 
 	template <typename char_t>
-	typename tokeniser<char_t>::range tokeniser<char_t>::next_number(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+	typename tokeniser<char_t>::range tokeniser<char_t>::next_whitespace(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
 		{
-		const range first_half{next_if(begin, [](const codepoint_with_range& cpwr)
+		return next_run(begin, character_classes::whitespace);
+		}
+
+	template <typename char_t>
+	typename tokeniser<char_t>::range tokeniser<char_t>::next_identifier(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+		{
+		const bool xid{identifiers == identifier_syntax::xid};
+		if (begin.it == this->end() || !(character_classes::of(next_codepoint_raw(begin.it).codepoint) & (xid ? character_classes::xid_start : character_classes::identifier_start)))
 			{
-			const bool ret{cpwr.codepoint >= U'0' && cpwr.codepoint <= U'9'};
-			return ret;
-			})};
+			return range{begin, begin};
+			}
+		//Every start codepoint is also a continue codepoint.
+		return next_run(begin, xid ? character_classes::xid_continue : character_classes::identifier_continue);
+		}
+
+	template <typename char_t>
+	typename tokeniser<char_t>::range tokeniser<char_t>::next_number(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+		{
+		const auto is_unit{[this](const iterator& it, std::same_as<char> auto... units) { return it != this->end() && ((*it == static_cast<char_t>(units)) || ...); }};
+		const auto is_digit{[this](const iterator& it) { return it != this->end() && *it >= static_cast<char_t>('0') && *it <= static_cast<char_t>('9'); }};
 
-		if (first_half.end.it == this->end()) { return first_half; }
+		const iterator_with_info mantissa_begin{is_unit(begin.it, '+', '-') ? next_to(begin, begin.it + 1).end : begin};
+		const range integer_part{next_run(mantissa_begin, character_classes::digit)};
+		range ret{begin, integer_part.end};
+		bool has_digits{!integer_part.empty()};
 
-		const auto mid_codepoint{next_codepoint(first_half.end)};
-		if (mid_codepoint.codepoint != U'.')
+		if (is_unit(ret.end.it, '.') && ret.end.it + 1 != this->end())
 			{
-			return first_half;
+			const range fractional_part{next_run(next_to(ret.end, ret.end.it + 1).end, character_classes::digit)};
+			has_digits = has_digits || !fractional_part.empty();
+			ret.end = fractional_part.end;
 			}
+		if (!has_digits) { return range{begin, begin}; }
+
+		//The exponent is only part of the number if it has digits, otherwise the 'e' is left to whatever follows.
+		if (is_unit(ret.end.it, 'e', 'E'))
+			{
+			const iterator exponent_digits_it{is_unit(ret.end.it + 1, '+', '-') ? ret.end.it + 2 : ret.end.it + 1};
+			if (is_digit(exponent_digits_it))
+				{
+				ret.end = next_run(next_to(ret.end, exponent_digits_it).end, character_classes::digit).end;
+				}
+			}
+		return ret;
+		}
 
-		if (mid_codepoint.range.end.it == this->end()) { return first_half; }
 
-		const range second_half{next_if(mid_codepoint.range.end, [](const codepoint_with_range& cpwr)
+	template <typename char_t>
+	typename tokeniser<char_t>::range tokeniser<char_t>::next_string(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+		{
+		return next_string_literal(begin).quoted;
+		}
+
+	template <typename char_t>
+	typename tokeniser<char_t>::string_literal tokeniser<char_t>::next_string_literal(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+		{
+		if (begin.it == this->end() || *begin.it != static_cast<char_t>('\"')) { return string_literal{.quoted{begin, begin}, .content{}, .has_escapes{false}}; }
+
+		//Quotation marks and backslashes are ASCII, so they can't be part of multi-unit sequences and an escaped code unit is never either of them
+		//unless it's one itself: skipping a single unit after a backslash is always right.
+		iterator it{begin.it + 1};
+		bool has_escapes{false};
+		bool terminated{false};
+		while (it != this->end())
 			{
-			const bool ret{cpwr.codepoint >= U'0' && cpwr.codepoint <= U'9'};
-			return ret;
-			})};
+			iterator found{this->end()};
+			simd::for_each_block(it, this->end(), [&](const simd::block<char_t>& block, size_t block_begin)
+				{
+				const simd::mask_t mask{block.equal(static_cast<char_t>('\"')) | block.equal(static_cast<char_t>('\\'))};
+				if (!mask) { return false; }
+				found = it + block_begin + static_cast<size_t>(std::countr_zero(mask));
+				return true;
+				});
+			if (found == this->end()) { it = found; break; }
+
+			if (*found == static_cast<char_t>('\"'))
+				{
+				it = found + 1;
+				terminated = true;
+				break;
+				}
+			has_escapes = true;
+			it = (found + 1 == this->end()) ? found + 1 : found + 2;
+			}
 
-		return range{first_half.begin, second_half.end};
+		const range ret_range{next_to(begin, it)};
+		return string_literal
+			{
+			.quoted     {ret_range},
+			.content    {view_t{begin.it + 1, terminated ? it - 1 : it}},
+			.has_escapes{has_escapes}
+			};
 		}
 
 
 	template <typename char_t>
-	typename tokeniser<char_t>::range tokeniser<char_t>::next_string(const typename tokeniser<char_t>::iterator_with_info& begin) const noexcept
+	typename tokeniser<char_t>::token tokeniser<char_t>::next_token(const typename tokeniser<char_t>::iterator_with_info& begin, string_arena<char_t>& strings) const
 		{
-		const codepoint_with_range first{next_codepoint(begin)};
-		if (first.codepoint != U'\"')
+		if (begin.it == this->end()) { return token{range{begin, begin}}; }
+
+		const char32_t first{static_cast<std::make_unsigned_t<char_t>>(*begin.it) < 0x80 ? static_cast<char32_t>(*begin.it) : next_codepoint_raw(begin.it).codepoint};
+		const character_classes::mask_t first_classes{character_classes::of(first)};
+
+		if (first == U'\"')
 			{
-			return range{begin, begin};
+			const string_literal literal{next_string_literal(begin)};
+			if (!literal.has_escapes) { return token{literal.quoted, token_kind::string, literal.content}; }
+
+			//Decoding never makes the content longer.
+			char_t* const decoded_begin{strings.allocate(literal.content.size())};
+			char_t* decoded_end{decoded_begin};
+			const bool valid{decode_string(literal.content, decoded_end)};
+			strings.shrink_last(literal.content.size() - static_cast<size_t>(decoded_end - decoded_begin));
+			if (!valid)
+				{
+				throw std::runtime_error{"Error parsing string.\nInvalid escape sequence in \"" + utils::string::cast<char>(literal.quoted.string()) + "\"\n"
+					"At: " + begin.to_string()};
+				}
+			return token{literal.quoted, token_kind::string, view_t{decoded_begin, decoded_end}};
 			}
+		if (first == U'.' || first == U'+' || first == U'-' || (first_classes & character_classes::digit))
+			{
+			const range ret{next_number(begin)};
+			if (ret.empty()) { return token{ret}; }
+			return token{ret, token_kind::number, std::visit([](auto number) { return value_t{number}; }, decode_number(ret.string()))};
+			}
+		if (first_classes & (identifiers == identifier_syntax::xid ? character_classes::xid_start : character_classes::identifier_start))
+			{
+			return token{next_identifier(begin), token_kind::identifier};
+			}
+		return token{range{begin, begin}};
+		}
 
-		codepoint_with_range previous{first};
-		while (true)
+	template <typename char_t>
+	double tokeniser<char_t>::token::number() const noexcept
+		{
+		if (const auto integer_ptr{std::get_if<int64_t>(&value)}) { return static_cast<double>(*integer_ptr); }
+		if (const auto real_ptr   {std::get_if<double >(&value)}) { return *real_ptr; }
+		return 0.;
+		}
+
+	template <typename char_t>
+	std::variant<int64_t, double> tokeniser<char_t>::decode_number(view_t number)
+		{
+		//from_chars only reads char and doesn't accept a leading '+'. Numbers are ASCII, so narrowing each unit is enough.
+		if (!number.empty() && number.front() == static_cast<char_t>('+')) { number.remove_prefix(1); }
+		std::array<char, 64> small_buffer;
+		std::string big_buffer;
+		if (number.size() > small_buffer.size()) { big_buffer.resize(number.size()); }
+		char* const begin{big_buffer.empty() ? small_buffer.data() : big_buffer.data()};
+		char* const end  {begin + number.size()};
+		std::transform(number.begin(), number.end(), begin, [](char_t unit) { return static_cast<char>(unit); });
+
+		const char* const exponent_it{std::find_if(begin, end, [](char c) { return c == 'e' || c == 'E'; })};
+		if (exponent_it == end && std::find(begin, end, '.') == end)
 			{
-			if (previous.range.end.it == this->end())
+			int64_t ret{0};
+			if (std::from_chars(begin, end, ret).ec == std::errc{}) { return ret; }
+			}
+
+		double ret{0.};
+		if (std::from_chars(begin, end, ret).ec == std::errc::result_out_of_range)
+			{
+			//Tell overflow from underflow by the decimal exponent of the first significant digit.
+			const char* const mantissa_begin{begin[0] == '-' ? begin + 1 : begin};
+			const char* const dot_it{std::find(mantissa_begin, exponent_it, '.')};
+			const char* const first_significant_it{std::find_if(mantissa_begin, exponent_it, [](char c) { return c >= '1' && c <= '9'; })};
+			int64_t magnitude{first_significant_it < dot_it ? dot_it - first_significant_it : dot_it - first_significant_it + 1};
+			int64_t exponent{0};
+			if (exponent_it != end)
 				{
-				return range{begin, previous.range.end};
+				const char* const exponent_digits_it{exponent_it[1] == '+' ? exponent_it + 2 : exponent_it + 1};
+				if (std::from_chars(exponent_digits_it, end, exponent).ec != std::errc{}) { exponent = exponent_digits_it[0] == '-' ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max(); }
+				exponent = std::clamp<int64_t>(exponent, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max());
 				}
-			codepoint_with_range current{next_codepoint(previous.range.end)};
+			ret = magnitude + exponent > 0 ? std::numeric_limits<double>::infinity() : 0.;
+			if (begin[0] == '-') { ret = -ret; }
+			}
+		return ret;
+		}
 
-			if ((current.codepoint == U'\"') && (previous.codepoint != U'\\'))
+	template <typename char_t>
+	bool tokeniser<char_t>::decode_string(view_t content, char_t*& out)
+		{
+		bool ret{true};
+		while (true)
+			{
+			const size_t backslash_index{std::min(content.find(static_cast<char_t>('\\')), content.size())};
+			out = std::copy_n(content.data(), backslash_index, out);
+			if (backslash_index == content.size()) { return ret; }
+			if (backslash_index + 1 == content.size())
 				{
-				return range{begin, current.range.end};
+				//Lone backslash at the end of an unterminated string.
+				*out++ = content[backslash_index];
+				return false;
 				}
 
-			previous = current;
+			switch (content[backslash_index + 1])
+				{
+				case static_cast<char_t>('\\'): *out++ = static_cast<char_t>('\\'); break;
+				case static_cast<char_t>('\"' ): *out++ = static_cast<char_t>('\"' ); break;
+				case static_cast<char_t>('t' ): *out++ = static_cast<char_t>('\t' ); break;
+				case static_cast<char_t>('n' ): *out++ = static_cast<char_t>('\n' ); break;
+				default:
+					out = std::copy_n(content.data() + backslash_index, 2, out);
+					ret = false;
+					break;
+				}
+			content.remove_prefix(backslash_index + 2);
 			}
 		}
 
 
-
 	template <typename char_t>
 	bool tokeniser<char_t>::is_whitespace() const noexcept
 		{
@@ -239,53 +463,13 @@ namespace barnack::text_parser
 		}
 
 	template <typename char_t>
-	float tokeniser<char_t>::extract_number() const //TODO better function with less error, this was written in haste just to get the rest of the project going
+	float tokeniser<char_t>::extract_number() const
 		{
 		if (!is_number()) 
 			{
 			throw std::runtime_error{"Error extracting number from tokeniser.\nTokeniser does not contain a number. Check with \"is_number\" before calling \"extract_number\""};
 			}
-
-		float ret{0.f};
-
-		codepoint_with_range cp{next_codepoint(begin_with_info())};
-		while (true)
-			{
-			if (cp.codepoint == U'.')
-				{
-				break;
-				}
-			else
-				{
-				ret *= 10.f;
-				}
-
-			const float digit{static_cast<float>(cp.codepoint - U'0')};
-			ret += digit;
-
-			if (cp.range.end.it == this->end())
-				{
-				return ret;
-				}
-			cp = next_codepoint(cp.range.end);
-			}
-		cp = next_codepoint(cp.range.end);
-
-		float fractional_digits_multiplier{.1f};
-		while (true)
-			{
-			const float digit{static_cast<float>(cp.codepoint - U'0')};
-			ret += digit * fractional_digits_multiplier;
-
-			if (cp.range.end.it == this->end())
-				{
-				break;
-				}
-
-			fractional_digits_multiplier *= .1f;
-			cp = next_codepoint(cp.range.end);
-			}
-		return ret;
+		return std::visit([](auto number) { return static_cast<float>(number); }, decode_number(string));
 		}
 
 	template <typename char_t>
@@ -296,50 +480,16 @@ namespace barnack::text_parser
 			throw std::runtime_error{"Error extracting string from tokeniser.\nTokeniser does not contain a string. Check with \"is_string\" before calling \"extract_string\""};
 			}
 
-		std::basic_string<char_t> ret;
-
-		codepoint_with_range cp{next_codepoint(next_codepoint(begin_with_info()).range.end)};
-		while (true)
+		const view_t content{next_string_literal(begin_with_info()).content};
+		std::basic_string<char_t> ret(content.size(), char_t{});
+		char_t* end{ret.data()};
+		const bool valid{decode_string(content, end)};
+		ret.resize(static_cast<size_t>(end - ret.data()));
+		if (!valid)
 			{
-			if (cp.codepoint == U'\\')
-				{
-				codepoint_with_range after_backslash{next_codepoint(cp.range.end)};
-				if (after_backslash.codepoint == U'\\')
-					{
-					utf8::append(U'\\', std::back_inserter(ret));//TODO is this the right function?
-					}
-				else if (after_backslash.codepoint == U'\"')
-					{
-					utf8::append(U'\"', std::back_inserter(ret));
-					}
-				else if (after_backslash.codepoint == U't')
-					{
-					utf8::append(U'\t', std::back_inserter(ret));
-					}
-				else if (after_backslash.codepoint == U'n')
-					{
-					utf8::append(U'\n', std::back_inserter(ret));
-					}
-				else
-					{
-					throw std::runtime_error{"Error extracting string from tokeniser.\nInvalid escape sequence \"\\" + utils::string::cast<char>(after_backslash.range.string()) + "\""};
-					}
-				cp = next_codepoint(after_backslash.range.end);
-				}
-			else if (cp.codepoint == U'\"')
-				{
-				return ret;
-				}
-			else if (cp.range.end.it == this->end())
-				{
-				return ret;
-				}
-			else
-				{
-				utf8::append(cp.codepoint, std::back_inserter(ret));
-				cp = next_codepoint(cp.range.end);
-				}
+			throw std::runtime_error{"Error extracting string from tokeniser.\nInvalid escape sequence in \"" + utils::string::cast<char>(string) + "\""};
 			}
+		return ret;
 		}
 
 
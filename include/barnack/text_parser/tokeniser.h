@@ -1,10 +1,15 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
+#include <variant>
 
 #include <utils/string.h>
 #include <utils/memory.h>
 
+#include "character_classes.h"
+#include "string_arena.h"
+
 namespace barnack::text_parser
 	{
 	template <typename CHAR_T>
@@ -18,7 +23,7 @@ namespace barnack::text_parser
 
 		struct iterator_with_info
 			{
-			iterator it;
+			iterator it{nullptr};
 			size_t position{0};
 			size_t line{0};
 			size_t position_in_line{0};
@@ -35,6 +40,21 @@ namespace barnack::text_parser
 			bool   size  () const noexcept;
 			};
 
+		enum class token_kind { none, identifier, number, string };
+
+		//Decoded token: integer or floating point for numbers, unescaped content for strings, nothing for identifiers.
+		//String contents are views of the source if they have no escape sequences, of the string_arena passed to next_token otherwise.
+		using value_t = std::variant<std::monostate, int64_t, double, view_t>;
+
+		struct token : range
+			{
+			token_kind kind{token_kind::none};
+			value_t value{};
+
+			//Numbers as double whether they were written as integers or not, 0 for other kinds.
+			double number() const noexcept;
+			};
+
 		using codepoint = char32_t;
 
 		struct codepoint_with_range
@@ -47,17 +67,50 @@ namespace barnack::text_parser
 			codepoint codepoint;
 			view_t range;
 			};
+		struct string_literal
+			{
+			//Whole literal, quotation marks included.
+			range quoted;
+			//Between the quotation marks, escape sequences not replaced.
+			view_t content;
+			bool has_escapes{false};
+			};
 
-		tokeniser(view_t string);
+		enum class validation
+			{
+			//Every decoded codepoint is checked.
+			per_codepoint,
+			//The whole string is validated on construction, throwing std::runtime_error with the position of the first invalid sequence. Decoding is then unchecked.
+			upfront,
+			//Unchecked decoding of a string known to be valid, like a part of an upfront validated string split at codepoint boundaries.
+			assume_valid
+			};
+
+		enum class identifier_syntax
+			{
+			//[A-Za-z_][A-Za-z0-9_]*
+			ascii,
+			//Unicode identifiers: XID_Start or '_' followed by XID_Continue codepoints.
+			xid
+			};
+
+		tokeniser(view_t string, validation validation = validation::per_codepoint);
+		//For strings that are a part of a bigger document: positions and lines of every range are reported as if the string began at origin.
+		tokeniser(view_t string, const iterator_with_info& origin, validation validation = validation::per_codepoint);
 
 		view_t string;
+		iterator_with_info origin;
+		//True if decoding skips validation.
+		bool validated{false};
+		identifier_syntax identifiers{identifier_syntax::ascii};
 
 		iterator begin() const noexcept;
 		iterator_with_info begin_with_info() const noexcept;
 		iterator end() const noexcept;
 
-		codepoint_with_raw_range next_codepoint_raw(const iterator& begin) const noexcept;
-		codepoint_with_range next_codepoint(const iterator_with_info& begin) const noexcept;
+		//Throw std::runtime_error if begin is the end of the string, whatever the validation.
+		codepoint_with_raw_range next_codepoint_raw(const iterator& begin) const;
+		codepoint_with_range next_codepoint(const iterator_with_info& begin) const;
 
 		range next_until(const iterator_with_info& begin, auto&& callback) const noexcept
 			requires(std::same_as<bool, decltype(callback(codepoint_with_range{}))>)
@@ -84,10 +137,22 @@ namespace barnack::text_parser
 				});
 			}
 
+		//Range from begin to end without decoding the codepoints in between. Line information is obtained by counting newline code units.
+		range next_to(const iterator_with_info& begin, const iterator& end) const noexcept;
+
+		//Longest range starting at begin whose codepoints all belong to one of the classes of the mask.
+		range next_run(const iterator_with_info& begin, character_classes::mask_t mask) const noexcept;
+
 		range next_whitespace(const iterator_with_info& begin) const noexcept;
 		range next_identifier(const iterator_with_info& begin) const noexcept;
 		range next_number    (const iterator_with_info& begin) const noexcept;
 		range next_string    (const iterator_with_info& begin) const noexcept;
+		//Finds the closing quotation mark by jumping between quotation marks and backslashes, a backslash always escaping the code unit after it.
+		//Unterminated strings extend to the end. Empty range if begin isn't a quotation mark.
+		string_literal next_string_literal(const iterator_with_info& begin) const noexcept;
+		//Identifier, number or string starting at begin, told apart by the first codepoint so the token is scanned once, along with its decoded value.
+		//Strings with escape sequences are decoded into strings. Kind none and an empty range if begin starts none of them.
+		token next_token     (const iterator_with_info& begin, string_arena<char_t>& strings) const;
 		
 		bool is_whitespace() const noexcept;
 		bool is_identifier() const noexcept;
@@ -96,6 +161,12 @@ namespace barnack::text_parser
 
 		float extract_number() const;
 		std::basic_string<char_t> extract_string() const;
+
+		//Integer if the number has neither decimal separator nor exponent and fits in 64 bits, double otherwise. The number must be a valid next_number range.
+		static std::variant<int64_t, double> decode_number(view_t number);
+		//Writes a string_literal's content with escape sequences replaced to out, which must have room for content.size() code units, and advances out past it.
+		//Returns false if an unknown escape sequence was found, which is then written as is.
+		static bool decode_string(view_t content, char_t*& out);
 		};
 	}
 
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "simd.h"
+
+//Validation, decoding and conversions between UTF-8 (char and char8_t) and UTF-16 (char16_t).
+//Runs of ASCII are skipped or converted a whole simd block at a time, other sequences are validated and converted one codepoint at a time.
+namespace barnack::text_parser::transcode
+	{
+	namespace details
+		{
+		template <typename char_t>
+		inline constexpr bool is_utf8{sizeof(char_t) == 1};
+
+		[[noreturn]] inline void throw_invalid(const char* encoding, size_t index)
+			{
+			throw std::runtime_error{std::string{"Error transcoding text.\n"
+				"Invalid "} + encoding + " sequence at code unit " + std::to_string(index) + "."};
+			}
+
+		//Decodes the multi-byte sequence starting at index, rejecting overlong forms, surrogates and codepoints past U+10FFFF. Advances index past it on success.
+		inline bool try_decode_utf8(const uint8_t* data, size_t size, size_t& index, char32_t& codepoint) noexcept
+			{
+			const uint8_t lead{data[index]};
+
+			size_t length;
+			char32_t min;
+			if      ((lead & 0xE0) == 0xC0) { length = 2; codepoint = lead & 0x1F; min = 0x80;    }
+			else if ((lead & 0xF0) == 0xE0) { length = 3; codepoint = lead & 0x0F; min = 0x800;   }
+			else if ((lead & 0xF8) == 0xF0) { length = 4; codepoint = lead & 0x07; min = 0x10000; }
+			else { return false; }
+
+			if (size - index < length) { return false; }
+			for (size_t i{1}; i < length; i++)
+				{
+				const uint8_t continuation{data[index + i]};
+				if ((continuation & 0xC0) != 0x80) { return false; }
+				codepoint = (codepoint << 6) | (continuation & 0x3F);
+				}
+			if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) { return false; }
+
+			index += length;
+			return true;
+			}
+
+		inline char32_t decode_utf8(const uint8_t* data, size_t size, size_t& index)
+			{
+			char32_t codepoint;
+			if (!try_decode_utf8(data, size, index, codepoint)) { throw_invalid("UTF-8", index); }
+			return codepoint;
+			}
+
+		//Skips whole blocks of ASCII, returns the index of the first non-ASCII code unit at or after index, or size.
+		template <typename unit_t>
+		size_t skip_ascii(const unit_t* data, size_t size, size_t index) noexcept
+			{
+			while (index + simd::block_size <= size)
+				{
+				const simd::mask_t non_ascii{simd::block<unit_t>{data + index}.non_ascii()};
+				if (non_ascii) { return index + static_cast<size_t>(std::countr_zero(non_ascii)); }
+				index += simd::block_size;
+				}
+			while (index < size && static_cast<std::make_unsigned_t<unit_t>>(data[index]) < 0x80) { index++; }
+			return index;
+			}
+
+		inline size_t encode_utf8(char32_t codepoint, uint8_t* destination) noexcept
+			{
+			if (codepoint < 0x800)
+				{
+				destination[0] = static_cast<uint8_t>(0xC0 |  (codepoint >> 6));
+				destination[1] = static_cast<uint8_t>(0x80 |  (codepoint       & 0x3F));
+				return 2;
+				}
+			if (codepoint < 0x10000)
+				{
+				destination[0] = static_cast<uint8_t>(0xE0 |  (codepoint >> 12));
+				destination[1] = static_cast<uint8_t>(0x80 | ((codepoint >> 6) & 0x3F));
+				destination[2] = static_cast<uint8_t>(0x80 |  (codepoint       & 0x3F));
+				return 3;
+				}
+			destination[0] = static_cast<uint8_t>(0xF0 |  (codepoint >> 18));
+			destination[1] = static_cast<uint8_t>(0x80 | ((codepoint >> 12) & 0x3F));
+			destination[2] = static_cast<uint8_t>(0x80 | ((codepoint >>  6) & 0x3F));
+			destination[3] = static_cast<uint8_t>(0x80 |  (codepoint        & 0x3F));
+			return 4;
+			}
+
+		//Output must have room for size code units, UTF-16 never needs more units than UTF-8 has bytes. Returns the amount of units written.
+		inline size_t utf8_to_utf16(const uint8_t* data, size_t size, char16_t* output)
+			{
+			char16_t* it{output};
+			size_t index{0};
+			while (index < size)
+				{
+				while (index + simd::block_size <= size)
+					{
+					const simd::mask_t non_ascii{simd::block<uint8_t>{data + index}.non_ascii()};
+					if (non_ascii)
+						{
+						const size_t ascii_count{static_cast<size_t>(std::countr_zero(non_ascii))};
+						for (size_t i{0}; i < ascii_count; i++) { it[i] = data[index + i]; }
+						it    += ascii_count;
+						index += ascii_count;
+						break;
+						}
+					simd::widen(data + index, it);
+					it    += simd::block_size;
+					index += simd::block_size;
+					}
+				if (index >= size) { break; }
+
+				if (data[index] < 0x80)
+					{
+					*it++ = data[index++];
+					continue;
+					}
+
+				const char32_t codepoint{decode_utf8(data, size, index)};
+				if (codepoint < 0x10000) { *it++ = static_cast<char16_t>(codepoint); }
+				else
+					{
+					*it++ = static_cast<char16_t>(0xD800 + ((codepoint - 0x10000) >> 10));
+					*it++ = static_cast<char16_t>(0xDC00 + ((codepoint - 0x10000) & 0x3FF));
+					}
+				}
+			return static_cast<size_t>(it - output);
+			}
+
+		//Output must have room for 3 bytes per code unit. Returns the amount of bytes written.
+		inline size_t utf16_to_utf8(const char16_t* data, size_t size, uint8_t* output)
+			{
+			uint8_t* it{output};
+			size_t index{0};
+			while (index < size)
+				{
+				while (index + simd::block_size <= size)
+					{
+					const simd::mask_t non_ascii{simd::block<char16_t>{data + index}.non_ascii()};
+					if (non_ascii)
+						{
+						const size_t ascii_count{static_cast<size_t>(std::countr_zero(non_ascii))};
+						for (size_t i{0}; i < ascii_count; i++) { it[i] = static_cast<uint8_t>(data[index + i]); }
+						it    += ascii_count;
+						index += ascii_count;
+						break;
+						}
+					simd::narrow(data + index, it);
+					it    += simd::block_size;
+					index += simd::block_size;
+					}
+				if (index >= size) { break; }
+
+				const char16_t unit{data[index]};
+				if (unit < 0x80)
+					{
+					*it++ = static_cast<uint8_t>(unit);
+					index++;
+					continue;
+					}
+
+				char32_t codepoint{unit};
+				if (unit >= 0xD800 && unit <= 0xDBFF)
+					{
+					if (index + 1 >= size || data[index + 1] < 0xDC00 || data[index + 1] > 0xDFFF) { throw_invalid("UTF-16", index); }
+					codepoint = 0x10000 + ((static_cast<char32_t>(unit - 0xD800) << 10) | (data[index + 1] - 0xDC00));
+					index++;
+					}
+				else if (unit >= 0xDC00 && unit <= 0xDFFF) { throw_invalid("UTF-16", index); }
+				index++;
+				it += encode_utf8(codepoint, it);
+				}
+			return static_cast<size_t>(it - output);
+			}
+		}
+
+	inline constexpr size_t valid{std::string_view::npos};
+
+	//Index of the first code unit of the first invalid sequence, or valid.
+	template <typename char_t>
+	size_t validate(std::basic_string_view<char_t> string) noexcept
+		{
+		size_t index{0};
+		while (true)
+			{
+			index = details::skip_ascii(string.data(), string.size(), index);
+			if (index >= string.size()) { return valid; }
+
+			if constexpr (details::is_utf8<char_t>)
+				{
+				char32_t codepoint;
+				if (!details::try_decode_utf8(reinterpret_cast<const uint8_t*>(string.data()), string.size(), index, codepoint)) { return index; }
+				}
+			else
+				{
+				const char16_t unit{string[index]};
+				if (unit >= 0xD800 && unit <= 0xDBFF)
+					{
+					if (index + 1 >= string.size() || string[index + 1] < 0xDC00 || string[index + 1] > 0xDFFF) { return index; }
+					index += 2;
+					}
+				else if (unit >= 0xDC00 && unit <= 0xDFFF) { return index; }
+				else { index++; }
+				}
+			}
+		}
+
+	//Decodes the codepoint at it and advances it past it. The text must have been validated, nothing is checked.
+	template <typename char_t>
+	char32_t decode_unchecked(const char_t*& it) noexcept
+		{
+		if constexpr (details::is_utf8<char_t>)
+			{
+			const auto* bytes{reinterpret_cast<const uint8_t*>(it)};
+			const uint8_t lead{bytes[0]};
+			if (lead < 0x80)
+				{
+				it += 1;
+				return lead;
+				}
+			if (lead < 0xE0)
+				{
+				it += 2;
+				return (static_cast<char32_t>(lead & 0x1F) << 6) | (bytes[1] & 0x3F);
+				}
+			if (lead < 0xF0)
+				{
+				it += 3;
+				return (static_cast<char32_t>(lead & 0x0F) << 12) | (static_cast<char32_t>(bytes[1] & 0x3F) << 6) | (bytes[2] & 0x3F);
+				}
+			it += 4;
+			return (static_cast<char32_t>(lead & 0x07) << 18) | (static_cast<char32_t>(bytes[1] & 0x3F) << 12) | (static_cast<char32_t>(bytes[2] & 0x3F) << 6) | (bytes[3] & 0x3F);
+			}
+		else
+			{
+			const char16_t unit{it[0]};
+			if (unit < 0xD800 || unit > 0xDBFF)
+				{
+				it += 1;
+				return unit;
+				}
+			const char32_t codepoint{0x10000 + ((static_cast<char32_t>(unit - 0xD800) << 10) | static_cast<char32_t>(it[1] - 0xDC00))};
+			it += 2;
+			return codepoint;
+			}
+		}
+
+	//Appends string to output, converted to output's encoding. Throws std::runtime_error with the position of invalid sequences.
+	template <typename output_char_t, typename input_char_t>
+	void append(std::basic_string_view<input_char_t> string, std::basic_string<output_char_t>& output)
+		{
+		if constexpr (std::same_as<input_char_t, output_char_t>)
+			{
+			output.append(string);
+			}
+		else if constexpr (details::is_utf8<input_char_t> && details::is_utf8<output_char_t>)
+			{
+			const size_t previous_size{output.size()};
+			output.resize(previous_size + string.size());
+			std::memcpy(output.data() + previous_size, string.data(), string.size());
+			}
+		else if constexpr (details::is_utf8<input_char_t>)
+			{
+			const size_t previous_size{output.size()};
+			output.resize(previous_size + string.size());
+			const size_t written{details::utf8_to_utf16(reinterpret_cast<const uint8_t*>(string.data()), string.size(), output.data() + previous_size)};
+			output.resize(previous_size + written);
+			}
+		else
+			{
+			const size_t previous_size{output.size()};
+			output.resize(previous_size + string.size() * 3);
+			const size_t written{details::utf16_to_utf8(string.data(), string.size(), reinterpret_cast<uint8_t*>(output.data() + previous_size))};
+			output.resize(previous_size + written);
+			}
+		}
+
+	template <typename output_char_t, typename input_char_t>
+	std::basic_string<output_char_t> to(std::basic_string_view<input_char_t> string)
+		{
+		std::basic_string<output_char_t> ret;
+		append(string, ret);
+		return ret;
+		}
+	}
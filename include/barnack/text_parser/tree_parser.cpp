@@ -1,6 +1,11 @@
 #include "tree_parser.h"
 
+#include <limits>
+#include <vector>
 #include <cassert>
+#include <iterator>
+#include <algorithm>
+#include <exception>
 #include <stdexcept>
 
 namespace barnack::text_parser
@@ -12,192 +17,354 @@ namespace barnack::text_parser
 		}
 
 	template <typename char_t>
-	void tree_parser<char_t>::parse_all(tokeniser_t& tokeniser)
+	void tree_parser<char_t>::parse_all_parallel(tokeniser_t& tokeniser, size_t threads_count)
 		{
-		typename tokeniser_t::iterator_with_info it{tokeniser.begin_with_info()};
-		while (it.it != tokeniser.end())
+		if (this->open_bodies_count > 0 || threads_count < 2)
 			{
-			it = step(tokeniser, it);
+			this->parse_all(tokeniser);
+			return;
 			}
+
+		thread_pool pool{threads_count};
+		parse_all_parallel(tokeniser, pool);
 		}
 
 	template <typename char_t>
-	typename tree_parser<char_t>::tokeniser_t::iterator_with_info tree_parser<char_t>::step(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+	void tree_parser<char_t>::parse_all_parallel(tokeniser_t& tokeniser, thread_pool& pool)
 		{
-		const auto first_codepoint{tokeniser.next_codepoint(begin)};
-		if (first_codepoint.codepoint == U'}')
+		if (this->open_bodies_count > 0 || pool.threads_count() < 2)
+			{
+			this->parse_all(tokeniser);
+			return;
+			}
+
+		const structural_index<char_t> structural_index{tokeniser.string};
+		const auto split_points{structural_index.top_level_split_points(tokeniser.string, pool.threads_count())};
+
+		std::vector<size_t> boundaries{0};
+		boundaries.insert(boundaries.end(), split_points.positions.begin(), split_points.positions.end());
+		boundaries.push_back(tokeniser.string.size());
+
+		std::vector<tokeniser_t> parts_tokenisers;
+		typename tokeniser_t::iterator_with_info origin{tokeniser.begin_with_info()};
+		for (size_t i{0}; i + 1 < boundaries.size(); i++)
 			{
-			if (sequences_stack.size() <= 1) 
+			//Parts are split at structural characters, so they're valid if the whole is.
+			parts_tokenisers.emplace_back(tokeniser.string.substr(boundaries[i], boundaries[i + 1] - boundaries[i]), origin, tokeniser.validated ? tokeniser_t::validation::assume_valid : tokeniser_t::validation::per_codepoint);
+			parts_tokenisers.back().identifiers = tokeniser.identifiers;
+			origin = tokeniser.next_to(origin, tokeniser.begin() + boundaries[i + 1]).end;
+			}
+
+		//An incomplete last part is parsed by this parser, so its open bodies stay open for the next calls.
+		const size_t parallel_parts_count{parts_tokenisers.size() - (split_points.complete ? 0 : 1)};
+		std::vector<tree_parser<char_t>> parsers(parallel_parts_count);
+		std::vector<std::exception_ptr> errors(parallel_parts_count);
+
+		const auto parse_part{[&](size_t i, size_t)
+			{
+			try
+				{
+				parsers[i].symbol_table_ptr = this->symbol_table_ptr;
+				const auto part_structural_index{structural_index.slice(boundaries[i], boundaries[i + 1])};
+				parsers[i].parse_all(parts_tokenisers[i], part_structural_index);
+				}
+			catch (...)
 				{
-				throw std::runtime_error{"Curly brackets closed found without there being a matched opening.\n" + begin.to_string()};
+				errors[i] = std::current_exception();
 				}
-			sequences_stack.pop();
-			return first_codepoint.range.end;
+			}};
+
+		pool.for_each_index(parallel_parts_count, parse_part);
+
+		//The first error in document order, which is the one parse_all would have thrown.
+		for (const auto& error : errors)
+			{
+			if (error) { std::rethrow_exception(error); }
 			}
-		else if (first_codepoint.codepoint == U'\\')
+
+		auto& topmost_sequence{*sequences_stack.top()};
+		for (auto& parser : parsers)
 			{
-			return step_command(tokeniser, first_codepoint.range.end);
+			topmost_sequence.insert(topmost_sequence.end(), std::make_move_iterator(parser.root.children.begin()), std::make_move_iterator(parser.root.children.end()));
+			this->strings.splice(std::move(parser.strings));
 			}
-		else 
+
+		if (!split_points.complete)
 			{
-			return step_raw(tokeniser, begin);
+			this->parse_all(parts_tokenisers.back(), structural_index.slice(boundaries[boundaries.size() - 2], boundaries.back()));
 			}
 		}
 
-
 	template <typename char_t>
-	typename tree_parser<char_t>::tokeniser_t::iterator_with_info tree_parser<char_t>::step_raw(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
+	void tree_parser<char_t>::reparse(tokeniser_t& tokeniser, const edit& edit)
 		{
-		const typename tokeniser_t::range raw_text{tokeniser.next_until(begin, [](const tokeniser_t::codepoint_with_range& cpwr) -> bool
-			{
-			const auto ret{cpwr.codepoint == U'}' || cpwr.codepoint == U'\\'};
-			return ret;
-			})};
+		using iterator_with_info = typename tokeniser_t::iterator_with_info;
+		using range              = typename tokeniser_t::range;
 
-		//Only called if the first character is already valid as raw content, so the raw_text view should never be empty.
-		if(true && !raw_text.empty())
+		const size_t new_size{tokeniser.string.size()};
+		if (edit.begin > edit.old_end || edit.begin > edit.new_end || edit.new_end > new_size)
+			{
+			throw std::out_of_range{"Edit out of the bounds of the source passed to reparse."};
+			}
+		//Not the tree of a whole document.
+		if (this->open_bodies_count > 0)
 			{
-			assert(!raw_text.empty());//If this ever triggers (it shouldn't) remove the true from above. Or try to understand why it's happening to begin with.
-			auto& topmost_sequence{*(sequences_stack.top())};
-			auto& emplaced{std::get<tokeniser_t::range>(topmost_sequence.emplace_back(raw_text))};
+			parse_all_again(tokeniser);
+			return;
 			}
 
-		return {raw_text.end};
-		}
+		const size_t old_size{new_size - edit.new_end + edit.old_end};
+		const size_t origin  {tokeniser.origin.position};
 
+		bool found_splice{false};
+		//Elements tile their sequence, each one begins where the previous one ends. Commands begin with the backslash before their name.
+		//Only positions and lines are meaningful in the returned info, iterators still point into the old source.
+		const auto begin_of{[&](const sequence_element& element) -> iterator_with_info
+			{
+			if (const auto command_ptr{std::get_if<command>(&element)})
+				{
+				iterator_with_info ret{command_ptr->name.begin};
+				ret.position--;
+				ret.position_in_line--;
+				return ret;
+				}
+			if (const auto range_ptr{std::get_if<range>(&element)}) { return range_ptr->begin; }
+			found_splice = true;
+			return {.position{origin}};
+			}};
+		const auto position_of{[&](const sequence_element& element) { return begin_of(element).position - origin; }};
+		//Positions before the edit are the same in both sources.
+		const auto moved_to_new_source{[&](iterator_with_info info) { info.it = tokeniser.begin() + (info.position - origin); return info; }};
+		//Number of elements beginning at or before position.
+		const auto count_up_to{[&](const sequence& sequence, size_t position)
+			{
+			const auto it{std::upper_bound(sequence.begin(), sequence.end(), position, [&](size_t position, const sequence_element& element) { return position < position_of(element); })};
+			return static_cast<size_t>(it - sequence.begin());
+			}};
 
-	template <typename char_t>
-	typename tree_parser<char_t>::tokeniser_t::iterator_with_info tree_parser<char_t>::step_command(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
-		{
-		const typename tokeniser_t::range command_name{tokeniser.next_identifier(begin)};
+		struct ancestor_t
+			{
+			utils::observer_ptr<sequence> sequence_ptr;
+			size_t index;
+			};
+		std::vector<ancestor_t> ancestors;
+		utils::observer_ptr<sequence> sequence_ptr{std::addressof(root.children)};
+		size_t sequence_begin{0};
+		size_t sequence_end  {old_size};
+		iterator_with_info sequence_begin_info{tokeniser.begin_with_info()};
 
-		//Only called if the first character is already valid as raw content, so the raw_text view should never be empty.
-		if (command_name.empty())
+		//Descends into the body of the command containing the edit as long as its braces are left untouched.
+		while (true)
 			{
-			throw std::runtime_error
-				{
-				"Empty command. \"\\\" should be followed by a valid identifier\n"
-				"An identifier is a sequence of lower or upper case latin alphabet non-decorated letters, arabic numerals, and underscores.\n"
-				"It also cannot begin with arabic numerals.\n"
-				"Examples: \n"
-				"\t\\something;\n" 
-				"\t\\stuff_123\n" +
-				begin.to_string()
-				};
+			auto& sequence{*sequence_ptr};
+			const size_t count{count_up_to(sequence, edit.begin)};
+			if (found_splice || count == 0) { break; }
+
+			const size_t index{count - 1};
+			const auto command_ptr{std::get_if<command>(&sequence[index])};
+			if (!command_ptr) { break; }
+
+			const size_t command_end{index + 1 < sequence.size() ? position_of(sequence[index + 1]) : sequence_end};
+			const size_t body_end{command_end - 1};
+			//Past the edit, so body_end is shifted in the new source.
+			if (body_end < edit.old_end || tokeniser.string[body_end - edit.old_end + edit.new_end] != static_cast<char_t>('}')) { break; }
+
+			const size_t body_begin{command_ptr->children.empty() ? body_end : position_of(command_ptr->children.front())};
+			if (found_splice || edit.begin < body_begin) { break; }
+
+			sequence_begin_info = command_ptr->children.empty() ?
+				tokeniser.next_to(moved_to_new_source(command_ptr->name.begin), tokeniser.begin() + body_begin).end :
+				moved_to_new_source(begin_of(command_ptr->children.front()));
+
+			ancestors.push_back({sequence_ptr, index});
+			sequence_ptr   = std::addressof(command_ptr->children);
+			sequence_begin = body_begin;
+			sequence_end   = body_end;
 			}
 
-		auto& topmost_sequence{*(sequences_stack.top())};
-		auto& emplaced{std::get<command>(topmost_sequence.emplace_back(command{.name{command_name}}))};
+		//Elements [first, last) are parsed again: from the one before the edit, which may extend into it, to the one after it.
+		auto& sequence{*sequence_ptr};
+		const size_t first{edit.begin > sequence_begin && !sequence.empty() ? count_up_to(sequence, edit.begin - 1) - 1 : 0};
+		size_t last{edit.old_end >= sequence_end ? sequence.size() : count_up_to(sequence, edit.old_end)};
+		//A command turned into text would run into the raw text after it.
+		if (last < sequence.size() && std::holds_alternative<range>(sequence[last])) { last++; }
 
-		auto next_codepoint{tokeniser.next_codepoint(command_name.end)};
-		if (next_codepoint.codepoint == U'(')
+		const size_t fragment_begin  {first < sequence.size() ? position_of(sequence[first]) : sequence_begin};
+		const size_t fragment_old_end{last  < sequence.size() ? position_of(sequence[last ]) : sequence_end  };
+		const size_t fragment_new_end{fragment_old_end - edit.old_end + edit.new_end};
+		const iterator_with_info fragment_begin_info{first < sequence.size() ? moved_to_new_source(begin_of(sequence[first])) : sequence_begin_info};
+		if (found_splice)
 			{
-			const auto step_parameters_end{step_parameters(tokeniser, next_codepoint.range.end, emplaced.parameters)};
-			next_codepoint = tokeniser.next_codepoint(step_parameters_end);
+			parse_all_again(tokeniser);
+			return;
 			}
 
-		if (next_codepoint.codepoint == U'{')
+		tokeniser_t fragment_tokeniser{tokeniser.string.substr(fragment_begin, fragment_new_end - fragment_begin), fragment_begin_info, tokeniser.validated ? tokeniser_t::validation::assume_valid : tokeniser_t::validation::per_codepoint};
+		fragment_tokeniser.identifiers = tokeniser.identifiers;
+		tree_parser<char_t> fragment_parser;
+		fragment_parser.symbol_table_ptr = this->symbol_table_ptr;
+		try
 			{
-			//finalize command and add its children vector to the stack
-			sequences_stack.push(&emplaced.children);
-			return next_codepoint.range.end;
+			//An edit splitting a codepoint changes how the code units around it decode. Unless the fragment decodes to exactly its end in the whole
+			//source, the elements after it don't begin where they used to, nor on the same columns.
+			size_t position{fragment_begin};
+			while (position < fragment_new_end) { position += tokeniser.next_codepoint_raw(tokeniser.begin() + position).range.size(); }
+			if (position != fragment_new_end)
+				{
+				parse_all_again(tokeniser);
+				return;
+				}
+
+			fragment_parser.parse_all(fragment_tokeniser);
 			}
-		else if(next_codepoint.codepoint == U';')
+		catch (...)
 			{
-			return next_codepoint.range.end;
+			//The edit may reach past the fragment, like an unterminated string does. The whole document tells whether it's really an error.
+			parse_all_again(tokeniser);
+			return;
 			}
-		else
+		if (fragment_parser.open_bodies_count > 0)
 			{
-			throw std::runtime_error
-				{
-				"Invalid command termination.\n"
-				"Commands should be either followed by a curly brackets enclosed block, or a semicolon\n"
-				"Examples: \n"
-				"\t\\command;\n" 
-				"\t\\command{content}\n" 
-				"\t\\command(paramters);\n"
-				"\t\\command(paramters){content}\n" +
-				begin.to_string()
-				};
+			parse_all_again(tokeniser);
+			return;
 			}
-		}
-
 
-	template <typename char_t>
-	typename tree_parser<char_t>::tokeniser_t::range tree_parser<char_t>::next_parameter(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin)
-		{
-		typename tokeniser_t::range ret{tokeniser.next_identifier(begin)};
-		if (ret.empty()) 
+		//Ranges from the first element after the fragment onwards are shifted by as many positions, lines and columns as that element moved.
+		utils::observer_ptr<const sequence_element> next_ptr{nullptr};
+		if (last < sequence.size()) { next_ptr = std::addressof(sequence[last]); }
+		for (auto it{ancestors.rbegin()}; !next_ptr && it != ancestors.rend(); it++)
 			{
-			ret = tokeniser.next_number(begin);
+			if (it->index + 1 < it->sequence_ptr->size()) { next_ptr = std::addressof((*it->sequence_ptr)[it->index + 1]); }
 			}
-		if (ret.empty())
+		iterator_with_info old_next_info{.position{std::numeric_limits<size_t>::max()}};
+		iterator_with_info new_next_info{};
+		if (next_ptr)
 			{
-			ret = tokeniser.next_string(begin);
-			}
-		if (ret.empty())
-			{
-			throw std::runtime_error
+			old_next_info = begin_of(*next_ptr);
+			if (found_splice)
 				{
-				"Invalid command parameter. Command parameters must be valid identifier, a string, or number\n"
-				"An identifier is a sequence of lower or upper case latin alphabet non-decorated letters, arabic numerals, and underscores.\n"
-				"A string is a sequence of characters enclosed in quotation marks. A backspace can be used to escape the quotation marks symbols and continue the string.\n"
-				"A number is a sequence of arabic numerals, with one or no dot as decimal separator.\n"
-				"Examples: \n"
-				"\tparam\n"
-				"\tparam_qwerty_456\n"
-				"\t\"string!\"\n"
-				"\t\"string with a \\\"quotation\\\" symbol inside\"\n"
-				"\t123456\n"
-				"\t123.456\n"
-				"\t.123\n"
-				"\t123.\n" +
-				begin.to_string()
-				};
-			}
-		return ret;
-		}
-
+				parse_all_again(tokeniser);
+				return;
+				}
+			new_next_info = tokeniser.next_to(fragment_begin_info, tokeniser.begin() + (old_next_info.position - origin - edit.old_end + edit.new_end)).end;
+			}
 
-	template <typename char_t>
-	typename tree_parser<char_t>::tokeniser_t::iterator_with_info tree_parser<char_t>::step_parameters(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin, typename command::parameters_t& parameters_out)
-		{
-		typename tokeniser_t::iterator_with_info it{begin};
-				
-		while (true)
+		const auto update{[&](iterator_with_info& info)
 			{
-			it = tokeniser.next_whitespace(it).end;
-			const auto parameter{next_parameter(tokeniser, it)};
-			it = parameter.end;
-			parameters_out.emplace_back(parameter);
-			it = tokeniser.next_whitespace(it).end;
-			const auto next_codepoint{tokeniser.next_codepoint(it)};
-			if (next_codepoint.codepoint == U')')
+			if (info.position >= old_next_info.position)
 				{
-				return next_codepoint.range.end;
+				if (info.line == old_next_info.line) { info.position_in_line = info.position_in_line - old_next_info.position_in_line + new_next_info.position_in_line; }
+				info.line     = info.line     - old_next_info.line     + new_next_info.line;
+				info.position = info.position - old_next_info.position + new_next_info.position;
 				}
-			if (next_codepoint.codepoint == U',')
+			info.it = tokeniser.begin() + (info.position - origin);
+			}};
+		const auto update_element{[&](const auto& self, sequence_element& element) -> void
+			{
+			if (const auto command_ptr{std::get_if<command>(&element)})
 				{
-				it = next_codepoint.range.end;
+				update(command_ptr->name.begin);
+				update(command_ptr->name.end);
+				for (auto& parameter : command_ptr->parameters)
+					{
+					//Strings without escape sequences view the source right after the opening quote.
+					const auto string_ptr{std::get_if<view_t>(&parameter.value)};
+					const bool views_source{string_ptr && string_ptr->data() == parameter.string().data() + 1};
+					update(parameter.begin);
+					update(parameter.end);
+					if (views_source) { *string_ptr = view_t{parameter.string().data() + 1, string_ptr->size()}; }
+					}
+				for (auto& child : command_ptr->children) { self(self, child); }
 				}
-			else
+			else if (const auto range_ptr{std::get_if<range>(&element)})
 				{
-				throw std::runtime_error
-					{
-					"Invalid command parameters. Command parameters must be a round brackets enclosed sequence of comma separated valid identifiers or numbers\n"
-					"An identifier is a sequence of lower or upper case latin alphabet non-decorated letters, arabic numerals, and underscores.\n"
-					"A number is a sequence of arabic numerals, with one or no dot as decimal separator.\n"
-					"A comma is \",\" :)\n"
-					"Examples: \n"
-					"\t(param, param_qwerty_456, 123456)\n"
-					"\t(123.456, .123, 123.)\n" +
-					begin.to_string()
-					};
+				update(range_ptr->begin);
+				update(range_ptr->end);
 				}
+			}};
+		const auto update_from{[&](typename tree_parser<char_t>::sequence& elements, size_t index)
+			{
+			for (; index < elements.size(); index++) { update_element(update_element, elements[index]); }
+			}};
+
+		//Code units before the edit are the same in both sources, so if they are in the same buffer the ranges before the edit are left as they are.
+		const bool source_moved{[&]
+			{
+			if (root.children.empty()) { return false; }
+			const auto& element{root.children.front()};
+			if (const auto command_ptr{std::get_if<command>(&element)}) { return command_ptr->name.begin.it != tokeniser.begin() + (command_ptr->name.begin.position - origin); }
+			if (const auto range_ptr  {std::get_if<range  >(&element)}) { return range_ptr->begin.it       != tokeniser.begin() + (range_ptr->begin.position       - origin); }
+			return true;
+			}()};
+
+		sequence.erase(sequence.begin() + first, sequence.begin() + last);
+		if (source_moved) { update_from(root.children, 0); }
+		else
+			{
+			//The elements after the edit: the rest of the body containing it and the elements following each of the commands it's nested in.
+			update_from(sequence, first);
+			for (const auto& ancestor : ancestors) { update_from(*ancestor.sequence_ptr, ancestor.index + 1); }
 			}
+		sequence.insert(sequence.begin() + first, std::make_move_iterator(fragment_parser.root.children.begin()), std::make_move_iterator(fragment_parser.root.children.end()));
+		this->strings.splice(std::move(fragment_parser.strings));
+		}
+
+	template <typename char_t>
+	void tree_parser<char_t>::parse_all_again(tokeniser_t& tokeniser)
+		{
+		tree_parser<char_t> parser;
+		parser.symbol_table_ptr = this->symbol_table_ptr;
+		parser.parse_all(tokeniser);
+
+		//Moving the root keeps the nested sequences in place, only the root's own one moves.
+		std::vector<utils::observer_ptr<sequence>> open_sequences;
+		for (; !parser.sequences_stack.empty(); parser.sequences_stack.pop()) { open_sequences.push_back(parser.sequences_stack.top()); }
+		open_sequences.back() = std::addressof(root.children);
+
+		root                    = std::move(parser.root);
+		this->strings           = std::move(parser.strings);
+		this->open_bodies_count = parser.open_bodies_count;
+		last_command_ptr        = parser.last_command_ptr;
+		sequences_stack         = {};
+		for (auto it{open_sequences.rbegin()}; it != open_sequences.rend(); it++) { sequences_stack.push(*it); }
+		}
+
+	template <typename char_t>
+	void tree_parser<char_t>::on_raw(const typename tokeniser_t::range& raw_text)
+		{
+		auto& topmost_sequence{*(sequences_stack.top())};
+		topmost_sequence.emplace_back(raw_text);
+		}
+
+	template <typename char_t>
+	void tree_parser<char_t>::on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol)
+		{
+		auto& topmost_sequence{*(sequences_stack.top())};
+		last_command_ptr = std::addressof(std::get<command>(topmost_sequence.emplace_back(command{.name{name}, .name_symbol{name_symbol}, .parameters{}, .children{}})));
+		}
+
+	template <typename char_t>
+	void tree_parser<char_t>::on_parameter(const parameter& parameter)
+		{
+		assert(last_command_ptr);
+		last_command_ptr->parameters.emplace_back(parameter);
+		}
+
+	template <typename char_t>
+	void tree_parser<char_t>::on_body_begin()
+		{
+		//finalize command and add its children vector to the stack
+		assert(last_command_ptr);
+		sequences_stack.push(std::addressof(last_command_ptr->children));
+		}
+
+	template <typename char_t>
+	void tree_parser<char_t>::on_body_end()
+		{
+		sequences_stack.pop();
 		}
 
 	template class tree_parser<char16_t>;
 	template class tree_parser<char8_t>;
 	template class tree_parser<char>;
-	}
\ No newline at end of file
+	}
@@ -4,53 +4,103 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <thread>
 #include <variant>
 
 #include <utils/string.h>
 #include <utils/memory.h>
 
 #include "tokeniser.h"
+#include "parser_base.h"
+#include "thread_pool.h"
 
 namespace barnack::text_parser
 	{
 	template <typename CHAR_T>
-	class tree_parser
+	class tree_parser : public parser_base<CHAR_T>
 		{
 		public:
 			tree_parser();
 
-			using char_t         = CHAR_T;
-			using view_t         = std::basic_string_view <char_t>;
-			using string_t       = std::basic_string      <char_t>;
-			using stringstream_t = std::basic_stringstream<char_t>;
-			using tokeniser_t    = tokeniser<char_t>;
+			using char_t         = typename parser_base<CHAR_T>::char_t;
+			using view_t         = typename parser_base<CHAR_T>::view_t;
+			using string_t       = typename parser_base<CHAR_T>::string_t;
+			using stringstream_t = typename parser_base<CHAR_T>::stringstream_t;
+			using tokeniser_t    = typename parser_base<CHAR_T>::tokeniser_t;
+			using symbol_t       = typename parser_base<CHAR_T>::symbol_t;
+			using parameter      = typename parser_base<CHAR_T>::parameter;
 
 			struct command;
-			using sequence_element = std::variant<command, typename tokeniser_t::range>;
+			struct splice;
+			using sequence_element = std::variant<command, typename tokeniser_t::range, splice>;
 			using sequence = std::vector<sequence_element>;
 
+			//Non-owning reference to a sequence owned by another tree, which must outlive it. Places a body in another tree without copying it.
+			//Never produced by parsing, code walking children should go through for_each_element to see the spliced elements.
+			struct splice
+				{
+				utils::observer_ptr<const sequence> sequence_ptr{nullptr};
+				};
+
+			//Calls callback(element) for every command and range of the sequence, walking into splices as if their elements were part of it.
+			static void for_each_element(const sequence& sequence, auto&& callback)
+				{
+				for (const auto& element : sequence)
+					{
+					if (const auto splice_ptr{std::get_if<splice>(&element)}) { for_each_element(*splice_ptr->sequence_ptr, callback); }
+					else { callback(element); }
+					}
+				}
+
+			//Ranges are full tokeniser ranges with line information. The compact alternative, offsets with lines recovered on demand, is flat_tree.
 			struct command
 				{
-				using parameters_t = std::vector<typename tokeniser_t::range>;
+				using parameters_t = std::vector<parameter>;
 				typename tokeniser_t::range name;
+				symbol_t name_symbol{symbol_table::none};
 				parameters_t parameters;
 				sequence children;
 				};
 
 			command root;
 			std::stack<utils::observer_ptr<sequence>> sequences_stack;
-			
-			void parse_all(tokeniser_t& tokeniser);
+
+			//Splits the document at top level and parses the parts on the pool's threads, stitching them in order. Same result as parse_all.
+			//Parses serially while previous calls left bodies open. If the document leaves bodies open, its last part is parsed by this parser after the others.
+			//Must not be called from a job of the same pool.
+			void parse_all_parallel(tokeniser_t& tokeniser, thread_pool& pool);
+			//Creates a pool of threads_count threads for this call only, pass a pool to parse many documents.
+			void parse_all_parallel(tokeniser_t& tokeniser, size_t threads_count = std::thread::hardware_concurrency());
+
+			//The code units [begin, old_end) of the previously parsed source were replaced by the ones now at [begin, new_end). Positions are from the beginning of the source.
+			struct edit
+				{
+				size_t begin;
+				size_t old_end;
+				size_t new_end;
+				};
+
+			//Updates the tree parse_all built for a whole document to the edited document, which tokeniser must refer to with the same origin.
+			//Only the elements touched by the edit in the innermost body containing it are parsed again, in place of the old ones. The other subtrees are kept,
+			//their ranges shifted past the edit. If the new source is in the same buffer as the previous one only the elements after the edit are visited, otherwise every range
+			//of the tree is moved to the new buffer, in time linear in the size of the tree. If the edit changes the nesting, splits a codepoint in a way that changes how the code units after it decode, or the tree has splices, the whole document is parsed again.
+			//The tree is left as it was if parsing throws. Decoded strings of replaced parameters stay in strings until a whole document parse.
+			void reparse(tokeniser_t& tokeniser, const edit& edit);
+
+		protected:
+			virtual void on_raw          (const typename tokeniser_t::range& raw_text ) override;
+			virtual void on_command_begin(const typename tokeniser_t::range& name, symbol_t name_symbol) override;
+			virtual void on_parameter    (const parameter& parameter) override;
+			virtual void on_body_begin   () override;
+			virtual void on_body_end     () override;
 
 		private:
-			typename tokeniser_t::iterator_with_info step           (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
-			typename tokeniser_t::iterator_with_info step_raw       (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
-			typename tokeniser_t::iterator_with_info step_command   (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
-			typename tokeniser_t::range              next_parameter (tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin);
-			typename tokeniser_t::iterator_with_info step_parameters(tokeniser_t& tokeniser, const typename tokeniser_t::iterator_with_info& begin, typename command::parameters_t& parameters_out);
+			utils::observer_ptr<command> last_command_ptr{nullptr};
+
+			void parse_all_again(tokeniser_t& tokeniser);
 		};
 	}
 
 #ifdef IMPLEMENTATION
 #include "tree_parser.cpp"
-#endif
\ No newline at end of file
+#endif
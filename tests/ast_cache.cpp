@@ -0,0 +1,175 @@
+//Trees stored in an ast_cache must load back as they were parsed, and damaged files must load as misses rather than as broken trees.
+//Standalone, returns non zero on failure. Build with the include directory and utils on the include path, as C++20.
+
+#define IMPLEMENTATION
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <filesystem>
+
+#include <barnack/text_parser/tokeniser.h>
+#include <barnack/text_parser/tree_parser.h>
+#include <barnack/text_parser/flat_tree.h>
+#include <barnack/text_parser/symbol_table.h>
+#include <barnack/text_parser/ast_cache.h>
+
+namespace text_parser = barnack::text_parser;
+
+namespace
+	{
+	int failures{0};
+
+	void check(bool condition, const std::string& what)
+		{
+		if (condition) { return; }
+		std::cerr << "Failed: " << what << "\n";
+		failures++;
+		}
+
+	bool same_offsets(const text_parser::compact_range<uint32_t>& a, const text_parser::compact_range<uint32_t>& b) noexcept
+		{
+		return a.begin == b.begin && a.end == b.end;
+		}
+
+	bool same_tree(const text_parser::flat_tree<char>& a, const text_parser::flat_tree<char>& b)
+		{
+		const bool same_sizes
+			{
+			a.kinds     .size() == b.kinds     .size() &&
+			a.parameters.size() == b.parameters.size()
+			};
+		if (!same_sizes) { return false; }
+
+		for (size_t i{0}; i < a.kinds.size(); i++)
+			{
+			const bool same_node
+				{
+				a.kinds            [i] == b.kinds            [i] &&
+				a.first_children   [i] == b.first_children   [i] &&
+				a.next_siblings    [i] == b.next_siblings    [i] &&
+				a.parameters_firsts[i] == b.parameters_firsts[i] &&
+				a.parameters_counts[i] == b.parameters_counts[i] &&
+				a.symbols          [i] == b.symbols          [i] &&
+				same_offsets(a.ranges[i], b.ranges[i])
+				};
+			if (!same_node) { return false; }
+			}
+		for (size_t i{0}; i < a.parameters.size(); i++)
+			{
+			const bool same_parameter
+				{
+				a.parameters_kinds  [i] == b.parameters_kinds  [i] &&
+				a.parameters_symbols[i] == b.parameters_symbols[i] &&
+				a.parameters_values [i] == b.parameters_values [i] &&
+				same_offsets(a.parameters[i], b.parameters[i])
+				};
+			if (!same_parameter) { return false; }
+			}
+		return true;
+		}
+
+	std::string read_file(const std::filesystem::path& path)
+		{
+		std::ifstream file{path, std::ios::binary};
+		return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+		}
+
+	void write_file(const std::filesystem::path& path, const std::string& bytes)
+		{
+		std::ofstream file{path, std::ios::binary | std::ios::trunc};
+		file << bytes;
+		}
+
+	void check_round_trip(const text_parser::ast_cache<char>& cache, const text_parser::symbol_table& symbol_table, const std::string& source)
+		{
+		const std::string quoted{"\"" + source + "\""};
+
+		text_parser::tokeniser<char> tokeniser{source};
+		text_parser::flat_tree_parser<char> flat_tree_parser{source};
+		flat_tree_parser.symbol_table_ptr = &symbol_table;
+		flat_tree_parser.parse_all(tokeniser);
+
+		text_parser::tokeniser<char> tree_tokeniser{source};
+		text_parser::tree_parser<char> tree_parser;
+		tree_parser.symbol_table_ptr = &symbol_table;
+		tree_parser.parse_all(tree_tokeniser);
+
+		check(!cache.load(source), quoted + " misses before being stored");
+
+		cache.store(source, tree_parser.root);
+		const auto from_tree{cache.load(source, &symbol_table)};
+		check(from_tree && same_tree(from_tree->tree, flat_tree_parser.tree), quoted + " loads back as parsed after storing a tree_parser tree");
+
+		cache.store(flat_tree_parser.tree);
+		const auto from_flat{cache.load(source, &symbol_table)};
+		check(from_flat && same_tree(from_flat->tree, flat_tree_parser.tree), quoted + " loads back as parsed after storing a flat_tree");
+
+		check(!cache.load(source + " "), quoted + " isn't loaded for another source");
+		const text_parser::ast_cache<char> xid_cache{cache.directory, text_parser::tokeniser<char>::identifier_syntax::xid};
+		check(!xid_cache.load(source), quoted + " isn't loaded for another identifier syntax");
+
+		//Flipped bytes may still describe a valid tree, loading must only not fail or read out of bounds.
+		const auto path {cache.path_of(source)};
+		const auto bytes{read_file(path)};
+		for (size_t i{0}; i < bytes.size(); i++)
+			{
+			std::string damaged{bytes};
+			damaged[i] ^= 0x5A;
+			write_file(path, damaged);
+			if (const auto loaded{cache.load(source, &symbol_table)}) { static_cast<void>(loaded->tree.to_command(loaded->tree.root())); }
+			}
+
+		write_file(path, bytes.substr(0, bytes.size() / 2));
+		check(!cache.load(source), quoted + " misses when its file is truncated");
+		}
+
+	//Links a node both as the first child of its previous sibling and as that sibling's next one. Every link still points forward.
+	void check_shared_link(const text_parser::ast_cache<char>& cache)
+		{
+		const std::string source{"\\a{x}\\b{y}"};
+		text_parser::tokeniser<char> tokeniser{source};
+		text_parser::flat_tree_parser<char> flat_tree_parser{source};
+		flat_tree_parser.parse_all(tokeniser);
+		cache.store(flat_tree_parser.tree);
+
+		const auto& tree{flat_tree_parser.tree};
+		const uint32_t a{tree.first_children[0]};
+		const uint32_t b{tree.next_siblings [a]};
+		check(a != text_parser::flat_tree<char>::none && b != text_parser::flat_tree<char>::none, "the shared link source has two commands");
+
+		const auto path{cache.path_of(source)};
+		std::string bytes{read_file(path)};
+		//The layout is internal to ast_cache.cpp, which IMPLEMENTATION compiles into this program.
+		const text_parser::file_layout layout{tree.kinds.size(), tree.parameters.size(), 0, sizeof(char)};
+		std::memcpy(bytes.data() + layout.first_children + a * sizeof(uint32_t), &b, sizeof(b));
+		write_file(path, bytes);
+
+		check(!cache.load(source), "a node referenced by two links misses");
+		}
+	}
+
+int main()
+	{
+	const auto directory{std::filesystem::temp_directory_path() / "barnack_text_parser_ast_cache_test"};
+	std::filesystem::remove_all(directory);
+
+	text_parser::symbol_table symbol_table;
+	symbol_table.intern("a");
+	symbol_table.intern("foo");
+
+	const text_parser::ast_cache<char> cache{directory};
+	for (const std::string source : {"hello \\a(foo, 12, -3.5e2, \"x\\\"y\", \"plain\", bar){in\\b;\nside}\nend \\c{\\d{\\e;}}", "", "plain text only", "\\x(\"\\\\\");\n\n\\y;"})
+		{
+		check_round_trip(cache, symbol_table, source);
+		}
+	check_shared_link(cache);
+
+	std::filesystem::remove_all(directory);
+
+	if (failures == 0) { std::cout << "All passed\n"; }
+	return failures == 0 ? 0 : 1;
+	}
@@ -0,0 +1,123 @@
+//Replacements execute other definitions through their expansion, so they must not make a subtree parallel when those definitions aren't reentrant.
+//Standalone, returns non zero on failure. Build with the include directory and utils on the include path, as C++20, linking threads.
+
+#define IMPLEMENTATION
+
+#include <mutex>
+#include <thread>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+#include <barnack/text_parser/tree_parser.h>
+#include <barnack/text_parser/flat_tree.h>
+#include <barnack/text_parser/output_sink.h>
+#include <barnack/text_parser/batch_engine.h>
+#include <barnack/text_parser/commands_executor.h>
+#include <barnack/text_parser/commands_definitions.h>
+#include <barnack/text_parser/parallel_commands_executor.h>
+
+namespace text_parser = barnack::text_parser;
+
+namespace
+	{
+	int failures{0};
+
+	void check(bool condition, const std::string& what)
+		{
+		if (condition) { return; }
+		std::cerr << "Failed: " << what << "\n";
+		failures++;
+		}
+
+	//Not reentrant, records whether it ever ran on another thread than the one that started the execution.
+	struct counter : text_parser::command_definition::base<char>
+		{
+		std::thread::id expected_thread{std::this_thread::get_id()};
+		std::mutex mutex;
+		bool ran_elsewhere{false};
+		size_t count{0};
+
+		virtual std::string name() const noexcept final override { return "counter"; }
+
+		virtual void on_begin(const text_parser::tree_parser<char>::command     & command, text_parser::execution_context<char>& context) final override { record(); }
+		virtual void on_begin(const text_parser::flat_tree  <char>::command_view& command, text_parser::execution_context<char>& context) final override { record(); }
+
+		void record()
+			{
+			std::scoped_lock lock{mutex};
+			if (std::this_thread::get_id() != expected_thread) { ran_elsewhere = true; }
+			count++;
+			}
+		};
+	}
+
+int main()
+	{
+	using replacement = text_parser::command_definition::runtime_defined_replacement<char>;
+	using rcp         = text_parser::command_definition::runtime_checked_parameters;
+
+	text_parser::command_definition::output_body_root<char, char> root;
+	text_parser::command_definition::output_body     <char, char> output_body;
+	counter counter;
+	replacement count_twice{{.name{"count_twice"}, .replacement_string_before_body_prototype{"\\counter;\\counter;"}, .replacement_string_after_body_prototype{""}, .parameters{rcp::parameters_type::absent{}}, .body{rcp::body_requirement::absent}}};
+
+	text_parser::commands_executor<char> commands_executor;
+	commands_executor.add_command(root);
+	commands_executor.add_command(output_body);
+	commands_executor.add_command(counter);
+	commands_executor.add_command(count_twice);
+
+	check(count_twice.reentrant(), "a replacement without cache is reentrant on its own");
+	check(!commands_executor.all_reentrant(), "the registry has a non reentrant definition");
+
+	std::string source;
+	for (size_t i{0}; i < 64; i++) { source += "\\output_body{x\\count_twice;\\count_twice;y}"; }
+
+	text_parser::tokeniser<char> tokeniser{source};
+	text_parser::tree_parser<char> tree_parser;
+	tree_parser.parse_all(tokeniser);
+	text_parser::flat_tree_parser<char> flat_tree_parser{tokeniser.string};
+	flat_tree_parser.parse_all(tokeniser);
+
+	text_parser::parallel_commands_executor<char, char, int> parallel_commands_executor{commands_executor};
+	parallel_commands_executor.threads_count = 4;
+	parallel_commands_executor.min_parallel_elements = 1;
+
+	for (const bool flat : {false, true})
+		{
+		std::string output;
+		text_parser::string_sink<char> output_sink{output};
+		text_parser::execution_context<char> context{commands_executor};
+		context.set_output<text_parser::output_sink<char>>(&output_sink);
+
+		counter.count = 0;
+		if (flat) { parallel_commands_executor.execute(flat_tree_parser.tree.root(), context); }
+		else      { parallel_commands_executor.execute(tree_parser.root            , context); }
+
+		const std::string kind{flat ? "flat_tree" : "tree_parser"};
+		check(!counter.ran_elsewhere, kind + ": a non reentrant definition reached through an expansion ran on a worker thread");
+		check(counter.count == 64 * 4, kind + ": every expansion executed");
+		}
+
+	//batch_engine rejects the registry, and checks again when a replacement's cache gets enabled after construction.
+	bool rejected{false};
+	try { text_parser::batch_engine<char, char, int> batch_engine{commands_executor, 2}; }
+	catch (const std::logic_error&) { rejected = true; }
+	check(rejected, "batch_engine rejects a registry with a non reentrant definition");
+
+	text_parser::commands_executor<char> reentrant_commands_executor;
+	reentrant_commands_executor.add_command(root);
+	reentrant_commands_executor.add_command(output_body);
+	reentrant_commands_executor.add_command(count_twice);
+	text_parser::batch_engine<char, char, int> batch_engine{reentrant_commands_executor, 2};
+
+	count_twice.expansion_cache.capacity = 8;
+	rejected = false;
+	try { batch_engine.process({std::string_view{"\\count_twice;"}}); }
+	catch (const std::logic_error&) { rejected = true; }
+	check(rejected, "batch_engine rejects a replacement whose cache was enabled after construction");
+
+	if (failures == 0) { std::cout << "All passed\n"; }
+	return failures == 0 ? 0 : 1;
+	}
@@ -0,0 +1,192 @@
+//Reparsing an edited document must give the tree a whole document parse gives, positions, lines and columns included.
+//Edits are random spans of code units, so they split multibyte codepoints too. Edited sources that aren't valid UTF-8 are skipped.
+//Edits are made either in a new string or in place, in a buffer with room for every edit, where reparse only shifts the ranges after the edit.
+//Standalone, returns non zero on failure. Build with the include directory and utils on the include path, as C++20.
+
+#define IMPLEMENTATION
+
+#include <deque>
+#include <array>
+#include <string>
+#include <random>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <barnack/text_parser/tokeniser.h>
+#include <barnack/text_parser/tree_parser.h>
+#include <barnack/text_parser/transcode.h>
+#include <barnack/text_parser/symbol_table.h>
+
+namespace text_parser = barnack::text_parser;
+
+namespace
+	{
+	using tree_parser_t = text_parser::tree_parser<char>;
+	using tokeniser_t   = text_parser::tokeniser<char>;
+
+	int failures{0};
+	std::mt19937 random_engine{12345};
+
+	void check(bool condition, const std::string& what)
+		{
+		if (condition) { return; }
+		std::cerr << "Failed: " << what << "\n";
+		failures++;
+		}
+
+	size_t random_below(size_t bound)
+		{
+		return std::uniform_int_distribution<size_t>{0, bound - 1}(random_engine);
+		}
+
+	void describe(std::ostream& stream, const tokeniser_t::iterator_with_info& info, const std::string& source)
+		{
+		stream << info.position << ':' << info.line << ':' << info.position_in_line;
+		if (info.it != source.data() + info.position) { stream << "(points elsewhere)"; }
+		}
+
+	void describe(std::ostream& stream, const tree_parser_t::sequence& sequence, const std::string& source, size_t depth)
+		{
+		for (const auto& element : sequence)
+			{
+			stream << std::string(depth, ' ');
+			if (const auto command_ptr{std::get_if<tree_parser_t::command>(&element)})
+				{
+				stream << "command ";
+				describe(stream, command_ptr->name.begin, source);
+				stream << ' ' << command_ptr->name.string() << " symbol " << command_ptr->name_symbol;
+				for (const auto& parameter : command_ptr->parameters)
+					{
+					stream << " (";
+					describe(stream, parameter.begin, source);
+					stream << '-';
+					describe(stream, parameter.end, source);
+					stream << " kind " << static_cast<int>(parameter.kind) << " symbol " << parameter.symbol;
+					if (const auto value_ptr{std::get_if<int64_t         >(&parameter.value)}) { stream << ' ' << *value_ptr; }
+					if (const auto value_ptr{std::get_if<double          >(&parameter.value)}) { stream << ' ' << *value_ptr; }
+					if (const auto value_ptr{std::get_if<std::string_view>(&parameter.value)}) { stream << " \"" << *value_ptr << '"'; }
+					stream << ')';
+					}
+				stream << '\n';
+				describe(stream, command_ptr->children, source, depth + 1);
+				}
+			else if (const auto range_ptr{std::get_if<tokeniser_t::range>(&element)})
+				{
+				stream << "raw ";
+				describe(stream, range_ptr->begin, source);
+				stream << '-';
+				describe(stream, range_ptr->end, source);
+				stream << '\n';
+				}
+			}
+		}
+
+	std::string describe(const tree_parser_t& tree_parser, const std::string& source)
+		{
+		std::ostringstream stream;
+		describe(stream, tree_parser.root.children, source, 0);
+		return stream.str();
+		}
+
+	//Multibyte codepoints are frequent, so that random edit boundaries often split them.
+	std::string random_content(size_t depth)
+		{
+		static constexpr std::array<std::string_view, 8> texts{"ab", "x y", "\n", "z\nq", "\u00E9", "\u20AC\n", "\U0001D11E", "1 \u00E9\u00E9"};
+		std::string ret;
+		const size_t elements_count{random_below(4)};
+		for (size_t i{0}; i < elements_count; i++)
+			{
+			switch (random_below(depth > 2 ? 2 : 5))
+				{
+				case 0:
+				case 1: ret += texts[random_below(texts.size())]; break;
+				case 2: ret += "\\c" + std::to_string(random_below(3)) + ";"; break;
+				case 3: ret += "\\p(a" + std::to_string(random_below(2)) + ", " + std::to_string(random_below(100)) + ", \"s\\\"\u00E9\", \"\u20AC\n\", -2.5){" + random_content(depth + 1) + "}"; break;
+				case 4: ret += "\\b{" + random_content(depth + 1) + "}"; break;
+				}
+			}
+		return ret;
+		}
+
+	//Complete or partial codepoints, braces and commands.
+	std::string random_insertion()
+		{
+		static constexpr std::array<std::string_view, 14> insertions{"", "x", "\n", "}", "{", "\\c1;", "\\b{\n}", "\"", "\u00E9", "\xC3", "\xA9", "\xE2\x82", "\x82\xAC", "\xA9\n\xC3"};
+		return random_below(3) == 0 ? random_content(1) : std::string{insertions[random_below(insertions.size())]};
+		}
+
+	void check_edits(const text_parser::symbol_table& symbol_table, tokeniser_t::validation validation, bool in_place)
+		{
+		size_t compared_count{0};
+		for (size_t document{0}; document < 2000; document++)
+			{
+			//Trees refer to their source until reparse moves them to the next one.
+			std::deque<std::string> sources{random_content(0) + random_content(0) + random_content(0)};
+			if (in_place) { sources.back().reserve(4096); }
+
+			tree_parser_t tree_parser;
+			tree_parser.symbol_table_ptr = &symbol_table;
+			tokeniser_t tokeniser{sources.back(), validation};
+			tree_parser.parse_all(tokeniser);
+
+			for (size_t step{0}; step < 4; step++)
+				{
+				const std::string& source{sources.back()};
+				const size_t begin  {random_below(source.size() + 1)};
+				const size_t old_end{begin + random_below(std::min<size_t>(source.size() - begin, 6) + 1)};
+				const std::string insertion{random_insertion()};
+				std::string edited{source.substr(0, begin) + insertion + source.substr(old_end)};
+				if (text_parser::transcode::validate(std::string_view{edited}) != text_parser::transcode::valid) { continue; }
+
+				const std::string description{"edit [" + std::to_string(begin) + ", " + std::to_string(old_end) + ") of \"" + source + "\" into \"" + edited + "\""};
+				const std::string before{describe(tree_parser, source)};
+				if (in_place) { sources.back().assign(edited); }
+				else { sources.push_back(std::move(edited)); }
+				const std::string& new_source{sources.back()};
+
+				tree_parser_t whole_parser;
+				whole_parser.symbol_table_ptr = &symbol_table;
+				tokeniser_t whole_tokeniser{new_source, validation};
+				bool whole_threw{false};
+				try { whole_parser.parse_all(whole_tokeniser); }
+				catch (const std::runtime_error&) { whole_threw = true; }
+
+				tokeniser_t new_tokeniser{new_source, validation};
+				bool reparse_threw{false};
+				try { tree_parser.reparse(new_tokeniser, {.begin{begin}, .old_end{old_end}, .new_end{begin + insertion.size()}}); }
+				catch (const std::runtime_error&) { reparse_threw = true; }
+
+				check(whole_threw == reparse_threw, description + ": reparse throws when parsing the whole document does");
+				if (whole_threw || reparse_threw)
+					{
+					//The previous source was overwritten by an edit in place.
+					check(in_place || describe(tree_parser, source) == before, description + ": the tree is left as it was when reparse throws");
+					break;
+					}
+
+				const std::string expected{describe(whole_parser, new_source)};
+				const std::string actual  {describe(tree_parser , new_source)};
+				check(actual == expected, description + ": reparse matches a whole document parse\nexpected:\n" + expected + "actual:\n" + actual);
+				if (actual != expected) { break; }
+				compared_count++;
+				}
+			}
+		check(compared_count > 1000, "enough edits are compared");
+		}
+	}
+
+int main()
+	{
+	text_parser::symbol_table symbol_table;
+	symbol_table.intern("c1");
+	symbol_table.intern("a0");
+	symbol_table.intern("b");
+
+	check_edits(symbol_table, tokeniser_t::validation::per_codepoint, false);
+	check_edits(symbol_table, tokeniser_t::validation::upfront      , false);
+	check_edits(symbol_table, tokeniser_t::validation::per_codepoint, true );
+
+	if (failures == 0) { std::cout << "All passed\n"; }
+	return failures == 0 ? 0 : 1;
+	}
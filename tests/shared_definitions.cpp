@@ -0,0 +1,138 @@
+//A definition registered with several commands_executors must behave in each one as if it was only registered there, although every executor has its own symbol table.
+//Standalone, returns non zero on failure. Build with the include directory and utils on the include path, as C++20.
+
+#define IMPLEMENTATION
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+#include <barnack/text_parser/tree_parser.h>
+#include <barnack/text_parser/commands_executor.h>
+#include <barnack/text_parser/commands_definitions.h>
+
+namespace text_parser = barnack::text_parser;
+
+namespace
+	{
+	int failures{0};
+
+	void check(bool condition, const std::string& what)
+		{
+		if (condition) { return; }
+		std::cerr << "Failed: " << what << "\n";
+		failures++;
+		}
+
+	//Counts its executions.
+	struct counted : text_parser::command_definition::base<char>
+		{
+		counted(std::string name) : inner_name{std::move(name)} {}
+
+		std::string inner_name;
+		size_t count{0};
+
+		virtual std::string name() const noexcept final override { return inner_name; }
+		virtual void on_begin(const text_parser::tree_parser<char>::command& command, text_parser::execution_context<char>& context) final override { count++; }
+		};
+
+	//Parses source with the executor's table, as the executor requires, and returns whether validating its first command throws.
+	bool validates(text_parser::commands_executor<char>& commands_executor, text_parser::command_definition::base<char>& definition, std::string_view source)
+		{
+		text_parser::tokeniser<char> tokeniser{source};
+		text_parser::tree_parser<char> tree_parser;
+		tree_parser.symbol_table_ptr = &commands_executor.symbols;
+		tree_parser.parse_all(tokeniser);
+
+		const text_parser::execution_context<char> context{commands_executor};
+		try { definition.validate(std::get<text_parser::tree_parser<char>::command>(tree_parser.root.children.front()), context); }
+		catch (const std::runtime_error&) { return false; }
+		return true;
+		}
+
+	//The accepted identifiers get different symbols in each table, and an identifier pick rejects gets in a the symbol "left" has in b.
+	void check_parameters_validation()
+		{
+		using replacement = text_parser::command_definition::runtime_defined_replacement<char>;
+		using rcp         = text_parser::command_definition::runtime_checked_parameters;
+
+		replacement pick{{.name{"pick"}, .replacement_string_before_body_prototype{""}, .replacement_string_after_body_prototype{""},
+			.parameters{rcp::parameters_type::exact{rcp::parameter_type::identifier{.one_of{"left", "right"}}}}, .body{rcp::body_requirement::absent}}};
+
+		text_parser::commands_executor<char> a;
+		a.add_command(pick);
+		a.symbols.intern("other");
+
+		text_parser::commands_executor<char> b;
+		b.symbols.intern("padding_0");
+		b.symbols.intern("padding_1");
+		b.add_command(pick);
+		check(a.symbols.find("other") == b.symbols.find("left"), "the tables give different identifiers the same symbol");
+
+		for (auto* commands_executor : {&a, &b})
+			{
+			const std::string which{commands_executor == &a ? "first" : "second"};
+			check( validates(*commands_executor, pick, "\\pick(left);" ), which + " executor accepts an identifier of the list");
+			check( validates(*commands_executor, pick, "\\pick(right);"), which + " executor accepts another identifier of the list");
+			check(!validates(*commands_executor, pick, "\\pick(other);"), which + " executor rejects an identifier out of the list");
+			}
+		}
+
+	//foo and bar get each other's symbols in the two tables. The expansions of x and y must execute foo in both executors.
+	//x is bound from its template. y names the command with its parameter, so it is expanded and cached instead.
+	void check_replacement_dispatch()
+		{
+		using replacement = text_parser::command_definition::runtime_defined_replacement<char>;
+		using rcp         = text_parser::command_definition::runtime_checked_parameters;
+
+		counted root{""};
+		counted foo {"foo"};
+		counted bar {"bar"};
+		replacement x{{.name{"x"}, .replacement_string_before_body_prototype{"\\foo;"}, .replacement_string_after_body_prototype{""}, .parameters{rcp::parameters_type::absent{}}, .body{rcp::body_requirement::absent}}};
+		replacement y{{.name{"y"}, .replacement_string_before_body_prototype{"\\fo\\#0;"}, .replacement_string_after_body_prototype{""}, .parameters{rcp::parameters_type::any{}}, .body{rcp::body_requirement::absent}}};
+		y.expansion_cache.capacity = 4;
+
+		text_parser::commands_executor<char> a;
+		a.add_command(root);
+		a.add_command(foo);
+		a.add_command(bar);
+		a.add_command(x);
+		a.add_command(y);
+
+		text_parser::commands_executor<char> b;
+		b.add_command(root);
+		b.add_command(bar);
+		b.add_command(foo);
+		b.add_command(x);
+		b.add_command(y);
+		check(a.symbols.find("foo") == b.symbols.find("bar"), "the tables give foo and bar each other's symbols");
+
+		//The first executor runs again once the second one cached its own expansion of y.
+		for (auto* commands_executor : {&a, &b, &a})
+			{
+			const std::string which{commands_executor == &a ? "first" : "second"};
+
+			text_parser::tokeniser<char> tokeniser{std::string_view{"\\x;\\y(o);"}};
+			text_parser::tree_parser<char> tree_parser;
+			tree_parser.symbol_table_ptr = &commands_executor->symbols;
+			tree_parser.parse_all(tokeniser);
+
+			foo.count = 0;
+			bar.count = 0;
+			for (const auto& element : tree_parser.root.children)
+				{
+				commands_executor->execute(std::get<text_parser::tree_parser<char>::command>(element));
+				}
+			check(foo.count == 2 && bar.count == 0, which + " executor executes the definition the expansions name");
+			}
+		}
+	}
+
+int main()
+	{
+	check_parameters_validation();
+	check_replacement_dispatch();
+
+	if (failures == 0) { std::cout << "All passed\n"; }
+	return failures == 0 ? 0 : 1;
+	}
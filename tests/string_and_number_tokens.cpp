@@ -0,0 +1,88 @@
+//Parse time values must follow the rules extract_string and extract_number apply: unknown escape sequences are errors, and only the characters of the number syntax belong to a number.
+//Standalone, returns non zero on failure. Build with the include directory and utils on the include path, as C++20.
+
+#define IMPLEMENTATION
+
+#include <string>
+#include <iostream>
+#include <stdexcept>
+
+#include <barnack/text_parser/tokeniser.h>
+#include <barnack/text_parser/tree_parser.h>
+#include <barnack/text_parser/flat_tree.h>
+
+namespace text_parser = barnack::text_parser;
+
+namespace
+	{
+	int failures{0};
+
+	void check(bool condition, const std::string& what)
+		{
+		if (condition) { return; }
+		std::cerr << "Failed: " << what << "\n";
+		failures++;
+		}
+
+	bool parses(std::string_view source, bool flat)
+		{
+		try
+			{
+			text_parser::tokeniser<char> tokeniser{source};
+			if (flat)
+				{
+				text_parser::flat_tree_parser<char> parser{source};
+				parser.parse_all(tokeniser);
+				}
+			else
+				{
+				text_parser::tree_parser<char> parser;
+				parser.parse_all(tokeniser);
+				}
+			}
+		catch (const std::runtime_error&) { return false; }
+		return true;
+		}
+
+	void check_escapes()
+		{
+		for (const bool flat : {false, true})
+			{
+			const std::string kind{flat ? "flat_tree" : "tree_parser"};
+			check( parses("\\a(\"x\\n\\t\\\\\\\"y\");", flat), kind + ": known escape sequences are accepted");
+			check(!parses("\\a(\"x\\qy\");"          , flat), kind + ": an unknown escape sequence is an error");
+			}
+
+		text_parser::tokeniser<char> tokeniser{"\\a(\"x\\ny\");"};
+		text_parser::tree_parser<char> parser;
+		parser.parse_all(tokeniser);
+		const auto& command{std::get<text_parser::tree_parser<char>::command>(parser.root.children.front())};
+		const auto value_ptr{std::get_if<std::string_view>(&command.parameters.front().value)};
+		check(value_ptr && *value_ptr == "x\ny", "escape sequences are decoded");
+		}
+
+	size_t number_size(std::string_view source)
+		{
+		const text_parser::tokeniser<char> tokeniser{source};
+		return tokeniser.next_number(tokeniser.begin_with_info()).string().size();
+		}
+
+	//A NUL code unit is neither a sign, a decimal point nor an exponent.
+	void check_numbers()
+		{
+		using namespace std::string_view_literals;
+		check(number_size("12\0" "5"sv ) == 2, "a NUL after the integer part isn't a decimal point");
+		check(number_size("\0" "5"sv   ) == 0, "a NUL isn't a sign");
+		check(number_size("1e\0" "5"sv ) == 1, "a NUL isn't an exponent sign");
+		check(number_size("-1.5e+3 "sv ) == 7, "signs, decimal point and exponent are part of the number");
+		}
+	}
+
+int main()
+	{
+	check_escapes();
+	check_numbers();
+
+	if (failures == 0) { std::cout << "All passed\n"; }
+	return failures == 0 ? 0 : 1;
+	}
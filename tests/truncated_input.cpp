@@ -0,0 +1,92 @@
+//Documents ending in the middle of a command must be reported as errors under every validation mode, without reading past the end of the source.
+//Each source is copied to a buffer of its exact size, so reading past it is caught by address sanitizer builds.
+//Standalone, returns non zero on failure. Build with the include directory and utils on the include path, as C++20.
+
+#define IMPLEMENTATION
+
+#include <memory>
+#include <string>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+#include <barnack/text_parser/tokeniser.h>
+#include <barnack/text_parser/tree_parser.h>
+#include <barnack/text_parser/flat_tree.h>
+#include <barnack/text_parser/structural_index.h>
+
+namespace text_parser = barnack::text_parser;
+
+namespace
+	{
+	int failures{0};
+
+	template <typename char_t>
+	std::basic_string<char_t> widen(std::string_view ascii)
+		{
+		return {ascii.begin(), ascii.end()};
+		}
+
+	template <typename char_t>
+	void check_truncated(std::string_view ascii_source, typename text_parser::tokeniser<char_t>::validation validation, bool use_structural_index, bool flat)
+		{
+		const std::basic_string<char_t> source{widen<char_t>(ascii_source)};
+		const auto buffer{std::make_unique_for_overwrite<char_t[]>(source.size())};
+		std::ranges::copy(source, buffer.get());
+		const std::basic_string_view<char_t> view{buffer.get(), source.size()};
+
+		bool threw{false};
+		try
+			{
+			text_parser::tokeniser<char_t> tokeniser{view, validation};
+			const text_parser::structural_index<char_t> structural_index{view};
+			if (flat)
+				{
+				text_parser::flat_tree_parser<char_t> parser{view};
+				if (use_structural_index) { parser.parse_all(tokeniser, structural_index); }
+				else                      { parser.parse_all(tokeniser); }
+				}
+			else
+				{
+				text_parser::tree_parser<char_t> parser;
+				if (use_structural_index) { parser.parse_all(tokeniser, structural_index); }
+				else                      { parser.parse_all(tokeniser); }
+				}
+			}
+		catch (const std::runtime_error&) { threw = true; }
+
+		if (!threw)
+			{
+			std::cerr << "Failed: \"" << ascii_source << "\" with " << sizeof(char_t) << " byte code units, validation " << static_cast<int>(validation)
+				<< (use_structural_index ? ", structural index" : "") << (flat ? ", flat_tree" : ", tree_parser") << " was accepted\n";
+			failures++;
+			}
+		}
+
+	template <typename char_t>
+	void check_all()
+		{
+		using validation = typename text_parser::tokeniser<char_t>::validation;
+		for (const std::string_view source : {"ab\\foo", "\\foo", "ab\\", "\\foo(", "\\foo(1", "\\foo(1,", "\\foo(1)", "\\foo(\"abc", "x\\a{\\b(2)"})
+			{
+			for (const validation validation : {validation::per_codepoint, validation::upfront, validation::assume_valid})
+				{
+				for (const bool use_structural_index : {false, true})
+					{
+					check_truncated<char_t>(source, validation, use_structural_index, false);
+					check_truncated<char_t>(source, validation, use_structural_index, true );
+					}
+				}
+			}
+		}
+	}
+
+int main()
+	{
+	check_all<char    >();
+	check_all<char8_t >();
+	check_all<char16_t>();
+
+	if (failures == 0) { std::cout << "All passed\n"; }
+	return failures == 0 ? 0 : 1;
+	}
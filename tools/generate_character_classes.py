@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#Generates include/barnack/text_parser/character_classes_tables.h from the Unicode character database of the Python running it.
+#Usage: python3 tools/generate_character_classes.py > include/barnack/text_parser/character_classes_tables.h
+#The tables follow unicodedata.unidata_version, update Python to update Unicode.
+#XID_Start and XID_Continue are what str.isidentifier checks, White_Space is listed below since no Python function matches it exactly.
+
+import sys
+import unicodedata
+
+stage_0_shift = 11
+stage_1_shift = 7
+
+#PropList.txt White_Space above U+00FF.
+white_space = {0x1680, *range(0x2000, 0x200B), 0x2028, 0x2029, 0x202F, 0x205F, 0x3000}
+
+def class_of(codepoint):
+	if codepoint < 0x100 or 0xD800 <= codepoint <= 0xDFFF: return 0
+	if codepoint in white_space: return 1
+	character = chr(codepoint)
+	if character.isidentifier(): return 3
+	if ("a" + character).isidentifier(): return 2
+	return 0
+
+def deduplicate(items):
+	indices = {}
+	unique = []
+	for item in items:
+		if item not in indices:
+			indices[item] = len(unique)
+			unique.append(item)
+	return unique, [indices[item] for item in items]
+
+def print_array(name, values):
+	print(f"\tinline constexpr std::array<uint8_t, {len(values)}> {name}")
+	print("\t\t{")
+	for i in range(0, len(values), 16):
+		print("\t\t" + " ".join(f"0x{value:02X}," for value in values[i:i + 16]))
+	print("\t\t};")
+
+def main():
+	block_size = 1 << stage_1_shift
+	blocks_per_row = 1 << (stage_0_shift - stage_1_shift)
+
+	blocks = []
+	for block_begin in range(0, 0x110000, block_size):
+		packed = bytearray(block_size // 4)
+		for index in range(block_size):
+			packed[index // 4] |= class_of(block_begin + index) << ((index % 4) * 2)
+		blocks.append(bytes(packed))
+	unique_blocks, blocks_indices = deduplicate(blocks)
+
+	rows = [tuple(blocks_indices[i:i + blocks_per_row]) for i in range(0, len(blocks_indices), blocks_per_row)]
+	unique_rows, rows_indices = deduplicate(rows)
+
+	if max(rows_indices) > 0xFF or len(unique_blocks) > 0x100: sys.exit("Indices don't fit in a byte anymore.")
+
+	print("#pragma once")
+	print()
+	print("#include <array>")
+	print("#include <cstddef>")
+	print("#include <cstdint>")
+	print()
+	print(f"//Generated from the Unicode {unicodedata.unidata_version} character database by tools/generate_character_classes.py, do not edit by hand.")
+	print("//Classes of the codepoints from U+0100 to U+10FFFF, 2 bits each: 0 none, 1 White_Space, 2 XID_Continue only, 3 XID_Start and XID_Continue.")
+	print("//Looked up in three stages: codepoint >> 11 selects a row of stage_1, (codepoint >> 7) & 15 a block of stage_2 within that row, and the block holds 128 codepoints packed 4 per byte.")
+	print("namespace barnack::text_parser::character_classes::tables")
+	print("\t{")
+	print(f"\tinline constexpr size_t stage_0_shift{{{stage_0_shift}}};")
+	print(f"\tinline constexpr size_t stage_1_shift{{{stage_1_shift}}};")
+	print()
+	print_array("stage_0", rows_indices)
+	print()
+	print_array("stage_1", [index for row in unique_rows for index in row])
+	print()
+	print_array("stage_2", [byte for block in unique_blocks for byte in block])
+	print("\t}")
+
+main()